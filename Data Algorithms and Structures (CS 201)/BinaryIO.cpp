@@ -0,0 +1,141 @@
+#ifndef CS201_BINARY_IO
+#define CS201_BINARY_IO
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <memory>
+#include <utility>
+using namespace std;
+
+//shared binary format for the save/load functions of the CS 201 containers
+//every stream starts with a 24 byte header: a 4 character tag naming the container, the format version, the byte
+//sizes of the key and value types (0 for variable sized ones like string) and the element count, numbers are written
+//in the machine's own byte order, so a file is read back on the same kind of machine it was written on
+
+static const uint32_t binaryFormatVersion = 1;
+
+//a count or length read from a stream is only trusted as far as the data behind it goes, memory for it is set aside
+//this many elements (or characters) at a time as they arrive, so a corrupt header runs out of stream and fails
+//instead of asking for more memory than the stream could ever fill
+static const size_t binaryReadChunk = 1 << 16;
+
+struct binaryHeader {
+    char tag[4];
+    uint32_t version;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint64_t count;
+};
+
+//how one element is written, trivially copyable types are their raw bytes, so whole arrays go in one read or write
+template <class T, class Enable = void>
+struct binaryCodec {
+    static_assert(is_trivially_copyable<T>::value, "no binaryCodec for this type, add a specialization");
+    static const uint32_t fixedSize = sizeof(T);
+
+    static void write(ostream &out, const T *a, size_t n) {
+        out.write(reinterpret_cast<const char *>(a), (streamsize)(n * sizeof(T)));
+    }
+    static bool read(istream &in, T *a, size_t n) {
+        in.read(reinterpret_cast<char *>(a), (streamsize)(n * sizeof(T)));
+        return (size_t)in.gcount() == n * sizeof(T);
+    }
+};
+
+//strings are a 64 bit length followed by their characters
+template <>
+struct binaryCodec<string> {
+    static const uint32_t fixedSize = 0;
+
+    static void write(ostream &out, const string *a, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            uint64_t length = a[i].size();
+            out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            out.write(a[i].data(), (streamsize)length);
+        }
+    }
+    static bool read(istream &in, string *a, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            uint64_t length;
+            if (!in.read(reinterpret_cast<char *>(&length), sizeof(length))) return false;
+            a[i].clear();
+            while (length > 0) {
+                size_t piece = length < binaryReadChunk ? (size_t)length : binaryReadChunk;
+                size_t start = a[i].size();
+                a[i].resize(start + piece);
+                if (!in.read(&a[i][start], (streamsize)piece)) return false;
+                length -= piece;
+            }
+        }
+        return true;
+    }
+};
+
+inline void writeBinaryHeader(ostream &out, const char *tag, uint32_t keySize, uint32_t valueSize, uint64_t count) {
+    binaryHeader header;
+    memcpy(header.tag, tag, 4);
+    header.version = binaryFormatVersion;
+    header.keySize = keySize;
+    header.valueSize = valueSize;
+    header.count = count;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+//whether in has at least bytes left before its end, false if the stream can't tell (a pipe, say), in is left where it was
+inline bool streamHolds(istream &in, uint64_t bytes) {
+    streampos here = in.tellg();
+    if (here == streampos(-1)) return false;
+    in.seekg(0, ios::end);
+    streampos end = in.tellg();
+    in.clear();
+    in.seekg(here);
+    return end != streampos(-1) && (uint64_t)(end - here) >= bytes;
+}
+
+//how many of count fixed size elements to read at once, all of them if the stream is seen to hold them,
+//binaryReadChunk otherwise
+template <class T>
+uint64_t binaryReadStep(istream &in, uint64_t count) {
+    if (binaryCodec<T>::fixedSize != 0 && streamHolds(in, count * binaryCodec<T>::fixedSize)) return count;
+    return binaryReadChunk;
+}
+
+//reads count elements into a new array, returns nullptr if the stream ends first
+//the array starts at one read step and doubles once that much has been read, a plain new[] so any element type works,
+//bool included, which vector would pack into bits
+template <class T>
+unique_ptr<T[]> readBinaryArray(istream &in, uint64_t count) {
+    uint64_t step = binaryReadStep<T>(in, count);
+    size_t capacity = (size_t)(count < step ? count : step);
+    unique_ptr<T[]> a(new T[capacity]);
+    size_t filled = 0;
+    while (filled < count) {
+        if (filled == capacity) {
+            size_t bigger = count - filled < capacity ? (size_t)count : 2 * capacity;
+            unique_ptr<T[]> grown(new T[bigger]);
+            for (size_t i = 0; i < filled; i++) grown[i] = std::move(a[i]);
+            a.swap(grown);
+            capacity = bigger;
+        }
+        size_t n = capacity - filled;
+        if (!binaryCodec<T>::read(in, a.get() + filled, n)) return nullptr;
+        filled += n;
+    }
+    return a;
+}
+
+//reads a header and checks it is for this container, version and element types, count gets the element count
+inline bool readBinaryHeader(istream &in, const char *tag, uint32_t keySize, uint32_t valueSize, uint64_t &count) {
+    binaryHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if (memcmp(header.tag, tag, 4) != 0 || header.version != binaryFormatVersion) return false;
+    if (header.keySize != keySize || header.valueSize != valueSize) return false;
+    count = header.count;
+    return true;
+}
+
+#endif
@@ -1,10 +1,349 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <memory>
 #include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "BinaryIO.cpp"
+#include "RingCapacity.cpp"
 using namespace std;
 
+//maps a value to an unsigned key whose unsigned order matches the value's order, used by radixSort
+//specialize it for a struct (a type and a static get) to radix sort the struct by one of its fields
+template <class T, class Enable = void>
+struct radixKey {};
+
+//unsigned integers are already in order
+template <class T>
+struct radixKey<T, typename enable_if<is_integral<T>::value && is_unsigned<T>::value>::type> {
+    typedef T type;
+    static type get(T v) {
+        return v;
+    }
+};
+
+//signed integers flip the sign bit so negatives sort below positives
+template <class T>
+struct radixKey<T, typename enable_if<is_integral<T>::value && is_signed<T>::value>::type> {
+    typedef typename make_unsigned<T>::type type;
+    static type get(T v) {
+        return static_cast<type>(static_cast<type>(v) ^ (type(1) << (sizeof(T) * 8 - 1)));
+    }
+};
+
+//floats and doubles flip every bit of a negative value and only the sign bit of a positive one
+template <class T>
+struct radixKey<T, typename enable_if<is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+    typedef typename conditional<sizeof(T) == 4, uint32_t, uint64_t>::type type;
+    static type get(T v) {
+        type bits;
+        memcpy(&bits, &v, sizeof(T));
+        type signBit = type(1) << (sizeof(T) * 8 - 1);
+        return (bits & signBit) ? ~bits : (bits ^ signBit);
+    }
+};
+
+//contiguous scans behind linearSearch, count, min, max and sum, these plain loops work for any element type
+template <class T, class Enable = void>
+struct ringScan {
+    static int find(const T *a, int n, const T &v) {
+        for (int i = 0; i < n; i++) {
+            if (a[i] == v) return i;
+        }
+        return -1;
+    }
+    static int count(const T *a, int n, const T &v) {
+        int c = 0;
+        for (int i = 0; i < n; i++) {
+            if (a[i] == v) c++;
+        }
+        return c;
+    }
+    static T minimum(const T *a, int n) { //n must be at least 1
+        T m = a[0];
+        for (int i = 1; i < n; i++) {
+            if (a[i] < m) m = a[i];
+        }
+        return m;
+    }
+    static T maximum(const T *a, int n) { //n must be at least 1
+        T m = a[0];
+        for (int i = 1; i < n; i++) {
+            if (m < a[i]) m = a[i];
+        }
+        return m;
+    }
+    static T sum(const T *a, int n) {
+        T total = T();
+        for (int i = 0; i < n; i++) total += a[i];
+        return total;
+    }
+    static int minIndex(const T *a, int n) { //n must be at least 1, returns the first of equal smallest elements
+        int best = 0;
+        for (int i = 1; i < n; i++) {
+            if (a[i] < a[best]) best = i;
+        }
+        return best;
+    }
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+//the 32 byte kernels are always inlined into AVX2 functions, so the ABI note GCC gives for them does not apply
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+//whether the running CPU has AVX2, checked once, every x86-64 CPU has SSE2 so that is the fallback
+inline bool cpuHasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+//vector kernels for the scans written with GCC vector extensions, bytes is the register width (16 for SSE2, 32 for
+//AVX2), everything is force inlined so the AVX2 entry points below compile it with AVX2 instructions
+template <class T, int bytes>
+struct vectorScan {
+    typedef T vec __attribute__((vector_size(bytes)));
+    typedef decltype(vec() == vec()) mask;
+    static const int width = bytes / sizeof(T);
+
+    static inline __attribute__((always_inline)) vec load(const T *p) {
+        vec x;
+        memcpy(&x, p, sizeof(vec));
+        return x;
+    }
+    static inline __attribute__((always_inline)) vec splat(T v) {
+        vec x;
+        for (int l = 0; l < width; l++) x[l] = v;
+        return x;
+    }
+    static inline __attribute__((always_inline)) bool any(const mask &m) {
+        uint64_t parts[bytes / 8];
+        memcpy(parts, &m, sizeof(mask));
+        uint64_t bits = 0;
+        for (int p = 0; p < bytes / 8; p++) bits |= parts[p];
+        return bits != 0;
+    }
+
+    //four registers per step so the loop keeps up with memory, the exact lane is only looked for after a hit
+    static inline __attribute__((always_inline)) int find(const T *a, int n, T v) {
+        vec target = splat(v);
+        int i = 0;
+        for (; i + 4 * width <= n; i += 4 * width) {
+            mask hit = (load(a + i) == target) | (load(a + i + width) == target) |
+                       (load(a + i + 2 * width) == target) | (load(a + i + 3 * width) == target);
+            if (any(hit)) break;
+        }
+        for (; i < n; i++) {
+            if (a[i] == v) return i;
+        }
+        return -1;
+    }
+
+    //matching lanes compare to -1, so subtracting the comparison counts them
+    static inline __attribute__((always_inline)) int count(const T *a, int n, T v) {
+        vec target = splat(v);
+        mask lanes = mask();
+        int i = 0;
+        for (; i + width <= n; i += width) lanes -= (load(a + i) == target);
+        int c = 0;
+        for (int l = 0; l < width; l++) c += (int)lanes[l];
+        for (; i < n; i++) c += (a[i] == v);
+        return c;
+    }
+
+    static inline __attribute__((always_inline)) T minimum(const T *a, int n) {
+        T m = a[0];
+        int i = 0;
+        if (n >= width) {
+            vec lanes = splat(a[0]);
+            for (; i + width <= n; i += width) {
+                vec x = load(a + i);
+                lanes = (x < lanes) ? x : lanes;
+            }
+            for (int l = 0; l < width; l++) {
+                if (lanes[l] < m) m = lanes[l];
+            }
+        }
+        for (; i < n; i++) {
+            if (a[i] < m) m = a[i];
+        }
+        return m;
+    }
+
+    static inline __attribute__((always_inline)) T maximum(const T *a, int n) {
+        T m = a[0];
+        int i = 0;
+        if (n >= width) {
+            vec lanes = splat(a[0]);
+            for (; i + width <= n; i += width) {
+                vec x = load(a + i);
+                lanes = (lanes < x) ? x : lanes;
+            }
+            for (int l = 0; l < width; l++) {
+                if (m < lanes[l]) m = lanes[l];
+            }
+        }
+        for (; i < n; i++) {
+            if (m < a[i]) m = a[i];
+        }
+        return m;
+    }
+
+    //floating point sums are added in a different order than the plain loop, so the last bits can differ
+    static inline __attribute__((always_inline)) T sum(const T *a, int n) {
+        vec lanes = vec();
+        int i = 0;
+        for (; i + width <= n; i += width) lanes += load(a + i);
+        T total = T();
+        for (int l = 0; l < width; l++) total += lanes[l];
+        for (; i < n; i++) total += a[i];
+        return total;
+    }
+
+    //index of the smallest of a[0, n) for n a multiple of width: a lane-wise minimum, then log2(width) shuffle steps
+    //leave the minimum in every lane, and the first lane equal to it is the answer, -1 if the minimum is NaN
+    static inline __attribute__((always_inline)) int minIndex(const T *a, int n) {
+        vec lanes = load(a);
+        for (int i = width; i < n; i += width) {
+            vec x = load(a + i);
+            lanes = (x < lanes) ? x : lanes;
+        }
+        for (int step = width / 2; step > 0; step /= 2) {
+            mask across;
+            for (int l = 0; l < width; l++) across[l] = l ^ step;
+            vec other = __builtin_shuffle(lanes, across);
+            lanes = (other < lanes) ? other : lanes;
+        }
+        for (int i = 0; i < n; i += width) {
+            mask hit = (load(a + i) == lanes);
+            uint64_t parts[bytes / 8];
+            memcpy(parts, &hit, sizeof(mask));
+            for (int p = 0; p < bytes / 8; p++) {
+                if (parts[p] != 0) return i + p * (int)(8 / sizeof(T)) + __builtin_ctzll(parts[p]) / (int)(8 * sizeof(T));
+            }
+        }
+        return -1;
+    }
+};
+
+//4 and 8 byte arithmetic types use the vector kernels, AVX2 when the CPU has it and SSE2 otherwise
+template <class T>
+struct ringScan<T, typename enable_if<is_arithmetic<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+    __attribute__((target("avx2"))) static int findAvx2(const T *a, int n, T v) { return vectorScan<T, 32>::find(a, n, v); }
+    __attribute__((target("avx2"))) static int countAvx2(const T *a, int n, T v) { return vectorScan<T, 32>::count(a, n, v); }
+    __attribute__((target("avx2"))) static T minimumAvx2(const T *a, int n) { return vectorScan<T, 32>::minimum(a, n); }
+    __attribute__((target("avx2"))) static T maximumAvx2(const T *a, int n) { return vectorScan<T, 32>::maximum(a, n); }
+    __attribute__((target("avx2"))) static T sumAvx2(const T *a, int n) { return vectorScan<T, 32>::sum(a, n); }
+    __attribute__((target("avx2"))) static int minIndexAvx2(const T *a, int n) { return vectorScan<T, 32>::minIndex(a, n); }
+
+    static int find(const T *a, int n, const T &v) {
+        return cpuHasAvx2() ? findAvx2(a, n, v) : vectorScan<T, 16>::find(a, n, v);
+    }
+    static int count(const T *a, int n, const T &v) {
+        return cpuHasAvx2() ? countAvx2(a, n, v) : vectorScan<T, 16>::count(a, n, v);
+    }
+    static T minimum(const T *a, int n) {
+        return cpuHasAvx2() ? minimumAvx2(a, n) : vectorScan<T, 16>::minimum(a, n);
+    }
+    static T maximum(const T *a, int n) {
+        return cpuHasAvx2() ? maximumAvx2(a, n) : vectorScan<T, 16>::maximum(a, n);
+    }
+    static T sum(const T *a, int n) {
+        return cpuHasAvx2() ? sumAvx2(a, n) : vectorScan<T, 16>::sum(a, n);
+    }
+    //whole registers only, other lengths and a NaN minimum take the plain loop
+    static int minIndex(const T *a, int n) {
+        int i = -1;
+        if (n % (32 / sizeof(T)) == 0 && cpuHasAvx2()) i = minIndexAvx2(a, n);
+        else if (n % (16 / sizeof(T)) == 0) i = vectorScan<T, 16>::minIndex(a, n);
+        if (i >= 0) return i;
+        int best = 0;
+        for (int j = 1; j < n; j++) {
+            if (a[j] < a[best]) best = j;
+        }
+        return best;
+    }
+};
+#pragma GCC diagnostic pop
+#endif
+
+//allocator whose blocks start on an Align byte boundary (a cache line by default), for arrays that want their
+//elements laid out on cache lines, like Heap's groups of children
+template <class T, size_t Align = 64>
+struct alignedAllocator {
+    static_assert(Align >= sizeof(void *) && (Align & (Align - 1)) == 0, "Align must be a power of two");
+    typedef T value_type;
+    template <class U> struct rebind { typedef alignedAllocator<U, Align> other; };
+
+    alignedAllocator() {}
+    template <class U> alignedAllocator(const alignedAllocator<U, Align> &) {}
+
+    //over-allocates by Align and keeps the pointer new returned just below the aligned block for deallocate
+    T *allocate(size_t n) {
+        char *raw = static_cast<char *>(::operator new(n * sizeof(T) + Align + sizeof(void *)));
+        uintptr_t start = (reinterpret_cast<uintptr_t>(raw) + sizeof(void *) + Align - 1) & ~(uintptr_t)(Align - 1);
+        reinterpret_cast<void **>(start)[-1] = raw;
+        return reinterpret_cast<T *>(start);
+    }
+    void deallocate(T *p, size_t) {
+        ::operator delete(reinterpret_cast<void **>(p)[-1]);
+    }
+};
+template <class T, class U, size_t Align>
+bool operator==(const alignedAllocator<T, Align> &, const alignedAllocator<U, Align> &) { return true; }
+template <class T, class U, size_t Align>
+bool operator!=(const alignedAllocator<T, Align> &, const alignedAllocator<U, Align> &) { return false; }
+
+//growth policy of CircularDynamicArray, these values are the behaviour the array has always had
+//a policy is any type with the same four members, deriving from this one and overriding a few is easiest
+struct DefaultGrowthPolicy {
+    static const int growthFactor = 2;    //a full array multiplies its capacity by this, must be a power of two
+    static const int shrinkDivisor = 4;   //an array that drops below capacity / shrinkDivisor halves its capacity
+    static const int minCapacity = 2;     //the array never shrinks below this, must be a power of two
+    static const bool neverShrink = false; //if true only shrinkToFit gives memory back
+};
+
+//never gives memory back on its own, for arrays that are filled and drained over and over
+struct NoShrinkGrowthPolicy : DefaultGrowthPolicy {
+    static const bool neverShrink = true;
+};
+
+//raw slots kept inside a CircularDynamicArray, nothing is constructed in them until the array uses a slot
+template <class N, int Cap>
+struct inlineStorage {
+    alignas(N) unsigned char bytes[sizeof(N) * Cap];
+    N *data() { return reinterpret_cast<N *>(bytes); }
+};
+
+//no inline slots, the array always lives on the heap
 template <class N>
+struct inlineStorage<N, 0> {
+    N *data() { return nullptr; }
+};
+
+//InlineCap elements are stored inside the object itself and the array only goes to the allocator once it outgrows
+//them, so small arrays never allocate, 0 (the default) turns this off
+//every buffer the array uses, including sort and select scratch, comes from Alloc, elements are still built with
+//placement new so a scoped allocator (pmr) is not passed on to the elements themselves
+template <class N, int InlineCap = 0, class Growth = DefaultGrowthPolicy, class Alloc = allocator<N> >
 class CircularDynamicArray {
+    static_assert(InlineCap >= 0 && (InlineCap & (InlineCap - 1)) == 0, "InlineCap must be 0 or a power of two");
+    static_assert(is_same<typename allocator_traits<Alloc>::value_type, N>::value, "Alloc must allocate N");
+    static_assert(is_same<typename allocator_traits<Alloc>::pointer, N *>::value, "Alloc must use plain pointers");
+    static_assert(Growth::growthFactor >= 2 && (Growth::growthFactor & (Growth::growthFactor - 1)) == 0,
+                  "growthFactor must be a power of two, the ring indexes with a mask");
+    static_assert(Growth::minCapacity >= 1 && (Growth::minCapacity & (Growth::minCapacity - 1)) == 0,
+                  "minCapacity must be a power of two");
+    //halving at capacity / 2 would leave the array full, so the next add would grow it straight back
+    static_assert(Growth::shrinkDivisor > 2, "shrinkDivisor must be more than 2 so that halving leaves free room");
+
 private:
     int MAX;
     int size;
@@ -12,310 +351,911 @@ private:
     N dummyElement;
     N *array;
 
-    //merges between the regular arrays and the circular array
-    void mergeIntoParent(N a[], N a1[], N a2[], int n) { 
-        //n1 = midway point, n2 = back
-        int n1 = n/2, n2 = n-n/2, i = 0; 
-        int p1 = 0, p2 = 0;
-
-        //compares sub-arrays and inserts correct value into parent array
-        while (p1 < n1 && p2 < n2) {
-            int index = (front + i) % MAX;
-            a[index] = a1[p1]<a2[p2] ? a1[p1++] : a2[p2++];
-            i++;
-        }
-
-        //slides up any leftover numbers ie if this array ends up still full after the first while loop
-        while (p1 < n1) {
-            int index = (front + i) % MAX;
-            a[index] = a1[p1++];
-            i++;
-        } 
-
-        //slides up any leftover numbers ie if this array ends up still full after the first while loop
-        while (p2 < n2) {
-            int index = (front + i) % MAX;
-            a[index] = a2[p2++];
-            i++;
-        }
-    }
-
-    //recursive helper function for regular arrays
-    void merge(N a[], N a1[], N a2[], int n) { 
-        int n1 = n/2, n2 = n-n/2, i = 0;
-        int p1 = 0, p2 = 0;
-        while (p1 < n1 && p2 < n2) 
-            a[i++] = a1[p1]<a2[p2] ? a1[p1++] : a2[p2++];
-        while (p1 < n1) a[i++] = a1[p1++];
-        while (p2 < n2) a[i++] = a2[p2++];
-    }
-
-    //recursive mergeSort call for regular arrays
-    void mergeSort(N a[], int n) { 
-        if (n <= 1) return;
-        N a1[n / 2];
-        N a2[n - (n / 2)];
-        for (int i = 0; i < n / 2; i++)
-            a1[i] = a[i];
-        for (int i = n / 2; i<n; i++)
-            a2[i-n/2] = a[i];
-        mergeSort(a1, n/2);
-        mergeSort(a2, n-n/2);
-        merge(a, a1, a2, n);
-    }
-
-    N quickSelect(vector<N> A, int k) {
-        N pivot = A.at(rand() % A.size()); //generates a random number between 0 and the size of the array
-        vector<N> L, E, G;
-        for (int i = 0; i < A.size(); i++) {
-            N element = A.at(i);
-            if (element < pivot) L.push_back(element);
-            else if (element == pivot) E.push_back(element);
-            else G.push_back(element);
-        }
-        if (k <= L.size()) return quickSelect(L, k);
-        else if (k <= L.size() + E.size()) return pivot;
-        else return quickSelect(G, k - L.size() - E.size());
-    }
-
-    N select(vector<N> A, int k) {
-        N pivot = medianOfMedians(A);
-        vector<N> L, E, G;
-        for (int i = 0; i < A.size(); i++) {
-            N element = A.at(i);
-            if (element < pivot) L.push_back(element);
-            else if (element == pivot) E.push_back(element);
-            else G.push_back(element);
-        }
-        if (k <= L.size()) return select(L, k);
-        else if (k <= L.size() + E.size()) return pivot;
-        else return select(G, k - L.size() - E.size());
-    }
-
-    N medianOfMedians (vector<N> A) {
-        vector<int> partitions;
-        for (int i = 0; i < A.size(); i += 5) {
-            partitions.push_back(i);
-        }
-
-        vector<N> medians;
-        int i;
-        for (i = 0; i < partitions.size(); i++) {
-            int low = partitions.at(i);
-            int high = (i + 1) * 5;
-            if (A.size() % 5 != 0 && i == partitions.size() - 1) break;
-            InsertionSort2(A, low, high);
-            
-            //select median of each group
-            medians.push_back(A.at( ((high - 1) + low) / 2) );
-        }
-
-        if (A.size() % 5 != 0) {
-            int low = partitions.at(i);
-            int high = A.size();
-            InsertionSort2(A, low, high);
-            
-            if (low == high) {
-                medians.push_back(A.at(low));
+    //optional Eytzinger (breadth first) copy of a sorted array built by buildSearchIndex, searchRank maps each
+    //slot back to its sorted index, both are 1-based and stay nullptr until an index is built
+    N *searchIndex;
+    int *searchRank;
+    int indexedSize;
+
+    Alloc alloc;
+    typedef allocator_traits<Alloc> traits;
+
+    //the ring lives here whenever MAX is at most InlineCap, so checking MAX tells where the ring is
+    inlineStorage<N, InlineCap> inlineSlots;
+
+    //Alloc rebound to T, and a vector using it, for the scratch index lists the algorithms keep
+    template <class T> using reboundAlloc = typename traits::template rebind_alloc<T>;
+    template <class T> using scratchVector = vector<T, reboundAlloc<T> >;
+
+    //moving an array only moves elements that sit in the inline slots, a heap ring just changes owner, so the move
+    //constructor can't throw unless those moves or dummyElement's default constructor can, being noexcept lets
+    //vector move arrays when it grows instead of copying them
+    static const bool nothrowSteal = (InlineCap == 0 || is_nothrow_move_constructible<N>::value) && is_nothrow_default_constructible<N>::value;
+    //move assignment copies the elements when the allocator stays behind and may differ from src's, an empty
+    //allocator type stands in for C++17's is_always_equal
+    static const bool nothrowMoveAssign = nothrowSteal && (traits::propagate_on_container_move_assignment::value || is_empty<Alloc>::value);
+
+    //MAX is always kept a power of two, so wrapping an index around the ring is a mask instead of a modulo
+    //the most elements the ring can ever have, see RingCapacity.cpp
+    static const int maxCapacity = maxRingCapacity;
+
+    int wrap(int i) {
+        return i & (MAX - 1);
+    }
+
+    //natural runs shorter than this are extended with insertion sort before merging
+    static const int minRun = 32;
+
+    //stable insertion sort of a[lo, hi) where a[lo, sortedEnd) is already in order
+    static void insertionSortRun(N *a, int lo, int sortedEnd, int hi) {
+        for (int i = sortedEnd; i < hi; i++) {
+            if (!(a[i] < a[i - 1])) continue; //already in place
+
+            //shifts larger elements up one and drops the element into the hole, equal elements are never passed
+            N temp = std::move(a[i]);
+            int j = i;
+            while (j > lo && temp < a[j - 1]) {
+                a[j] = std::move(a[j - 1]);
+                j--;
+            }
+            a[j] = std::move(temp);
+        }
+    }
+
+    //returns the end of the natural run starting at lo, a strictly descending run is reversed so it ascends
+    static int findRun(N *a, int lo, int n) {
+        int hi = lo + 1;
+        if (hi == n) return hi;
+        if (a[hi] < a[lo]) { //strictly descending, reversing it can't reorder equal elements since there are none
+            while (hi + 1 < n && a[hi + 1] < a[hi]) hi++;
+            reverse(a + lo, a + hi + 1);
+        }
+        else { //non-descending
+            while (hi + 1 < n && !(a[hi + 1] < a[hi])) hi++;
+        }
+        return hi + 1;
+    }
+
+    //stable merge of the sorted runs a[lo, mid) and a[mid, hi), the shorter run is moved out into scratch
+    static void mergeRuns(N *a, int lo, int mid, int hi, N *scratch) {
+        if (!(a[mid] < a[mid - 1])) return; //the runs are already in order
+
+        if (mid - lo <= hi - mid) { //left run is shorter, merges forwards from the front
+            int n1 = mid - lo;
+            for (int i = 0; i < n1; i++) {
+                new (&scratch[i]) N(std::move(a[lo + i]));
             }
-            else {
-                medians.push_back(A.at( ((high - 1) + low) / 2 ));
+            int p1 = 0, p2 = mid, out = lo;
+            while (p1 < n1 && p2 < hi) { //ties take from the left run to keep the sort stable
+                a[out++] = (a[p2] < scratch[p1]) ? std::move(a[p2++]) : std::move(scratch[p1++]);
+            }
+            while (p1 < n1) a[out++] = std::move(scratch[p1++]); //anything left of the right run is already in place
+            for (int i = 0; i < n1; i++) {
+                scratch[i].~N();
+            }
+        }
+        else { //right run is shorter, merges backwards from the back
+            int n2 = hi - mid;
+            for (int i = 0; i < n2; i++) {
+                new (&scratch[i]) N(std::move(a[mid + i]));
+            }
+            int p1 = mid - 1, p2 = n2 - 1, out = hi - 1;
+            while (p1 >= lo && p2 >= 0) { //ties take from the right run since this fills from the back
+                a[out--] = (scratch[p2] < a[p1]) ? std::move(a[p1--]) : std::move(scratch[p2--]);
+            }
+            while (p2 >= 0) a[out--] = std::move(scratch[p2--]);
+            for (int i = 0; i < n2; i++) {
+                scratch[i].~N();
             }
         }
+    }
 
-        if (medians.size() == 1) return medians.at(0);
-        else return medianOfMedians(medians);
+    //room runMergeSort needs in runStarts for n elements, every run but the last is at least minRun long
+    static int runSlots(int n) {
+        return n / minRun + 2;
     }
 
-    //version of InsertionSort for the base array
-    void InsertionSort(N arr[], int l, int h) {  
-        //returns if both l and h are the same, which only happens when calling insertion sort on an array of size 1
-        if (l == h) return;
+    //bottom-up natural merge sort of the contiguous a[0, n), scratch needs room for n / 2 elements and
+    //runStarts for runSlots(n) ints, both are passed in so the sort itself never allocates
+    static void runMergeSort(N *a, int n, N *scratch, int *runStarts) {
+        //splitting into natural runs, short runs are extended to minRun, so sorted input is a single run
+        int bounds = 0;
+        for (int lo = 0; lo < n; ) {
+            int hi = findRun(a, lo, n);
+            if (hi - lo < minRun) {
+                int forcedEnd = std::min(lo + minRun, n);
+                insertionSortRun(a, lo, hi, forcedEnd);
+                hi = forcedEnd;
+            }
+            runStarts[bounds++] = lo;
+            lo = hi;
+        }
+        runStarts[bounds++] = n;
 
-        //outer loop starts at 1, assumes index 0 is already sorted
-        for (int i = l + 1; i < h; i++){ 
-            int j = i;
+        //merging neighbouring runs in passes until one is left
+        while (bounds > 2) {
+            int kept = 0;
+            int runs = bounds - 1;
+            for (int r = 0; r < runs; r += 2) {
+                runStarts[kept++] = runStarts[r];
+                if (r + 1 < runs) mergeRuns(a, runStarts[r], runStarts[r + 1], runStarts[r + 2], scratch);
+            }
+            runStarts[kept++] = n;
+            bounds = kept;
+        }
+    }
 
-            //starts at i and goes backwards, performing a swap if need be until the element gets to the right spot
-            while (j > l && arr[(front + j - 1) % MAX] > arr[(front + j) % MAX]) { 
-                swap(arr[(front + j - 1) % MAX], arr[(front + j) % MAX]);
-                j--;
+    //smallest i where the first k outputs of the stable merge of A and B are A[0, i) and B[0, k - i), found by binary search
+    static int coRank(int k, N *A, int lenA, N *B, int lenB) {
+        int low = std::max(0, k - lenB), high = std::min(k, lenA);
+        while (low < high) {
+            int i = (low + high) / 2;
+            int j = k - i;
+            if (j == 0 || B[j - 1] < A[i]) high = i; //A[i] is not needed before B[j - 1], so i is far enough
+            else low = i + 1;
+        }
+        return low;
+    }
+
+    //outputs [o0, o1) of the stable merge of A and B into out, which are made of A[i, iEnd) and B[j, jEnd)
+    struct mergePiece {
+        N *A, *B, *out;
+        int i, iEnd, j, jEnd, o0, o1;
+    };
+
+    //adds the pieces of a merge pass that write outputs [k0, k1), the pass merges pairs of neighbouring runs of src into dst
+    //every worker's pieces are planned by the calling thread before any worker starts, a worker searching for its own
+    //split points would compare elements that the worker before it is already moving out
+    static void planMergePass(N *src, N *dst, const scratchVector<int> &bounds, int k0, int k1, scratchVector<mergePiece> &pieces) {
+        int runs = bounds.size() - 1;
+        for (int r = 0; r < runs; r += 2) {
+            int lo = bounds[r], mid = bounds[r + 1];
+            int hi = (r + 1 < runs) ? bounds[r + 2] : mid; //an odd run out is merged with an empty run, so just moved
+            if (hi <= k0 || lo >= k1) continue;
+            mergePiece p;
+            p.A = src + lo;
+            p.B = src + mid;
+            p.out = dst + lo;
+            p.o0 = std::max(k0, lo) - lo;
+            p.o1 = std::min(k1, hi) - lo;
+            p.i = coRank(p.o0, p.A, mid - lo, p.B, hi - mid);
+            p.j = p.o0 - p.i;
+            p.iEnd = coRank(p.o1, p.A, mid - lo, p.B, hi - mid);
+            p.jEnd = p.o1 - p.iEnd;
+            pieces.push_back(p);
+        }
+    }
+
+    //one thread's share of a merge pass, only reads the inputs its own pieces are made of
+    //construct is true when the outputs are raw storage
+    static void mergePieces(const mergePiece *pieces, int count, bool construct) {
+        for (int k = 0; k < count; k++) {
+            mergePiece p = pieces[k];
+            for (int o = p.o0; o < p.o1; o++) {
+                //ties take from A to keep the merge stable
+                N &next = (p.i == p.iEnd || (p.j < p.jEnd && p.B[p.j] < p.A[p.i])) ? p.B[p.j++] : p.A[p.i++];
+                if (construct) new (&p.out[o]) N(std::move(next));
+                else p.out[o] = std::move(next);
             }
-        } 
+        }
     }
 
-    //version of Insertion sort for the vectors
-    void InsertionSort2(vector<N> &vect, int l, int h) { 
-        if (l == h) return;
-        for (int i = l + 1; i < h; i++){ 
-            int j = i;
-            while (j > l && vect.at(j - 1) > vect.at(j)) {
-                swap(vect.at(j - 1), vect.at(j));
-                j--;
+    //integral arrays of at least this many elements are radix sorted by stableSort
+    static const int radixCutoff = 1024;
+
+    //stable sort of the linearized ring with the natural merge sort
+    void mergeSortAll() {
+        N *scratch = allocate(size / 2);
+        scratchVector<int> runStarts(runSlots(size), 0, alloc);
+        runMergeSort(linearize().data, size, scratch, &runStarts[0]);
+        deallocate(scratch, size / 2);
+    }
+
+    //integers that compare equal are identical, so a radix sort gives exactly the stableSort result
+    void sortByType(std::true_type) {
+        if (size >= radixCutoff) radixSort();
+        else mergeSortAll();
+    }
+
+    //everything else, including floating point where -0.0 and 0.0 would be split by a radix sort, is merge sorted
+    void sortByType(std::false_type) {
+        mergeSortAll();
+    }
+
+    //three-way partition of a[lo, hi) around pivot, afterwards a[lo, lt) < pivot, a[lt, gt) == pivot and a[gt, hi) > pivot
+    static void partition3(N *a, int lo, int hi, const N &pivot, int &lt, int &gt) {
+        lt = lo;
+        gt = hi;
+        int i = lo;
+        while (i < gt) {
+            if (a[i] < pivot) swap(a[lt++], a[i++]);
+            else if (pivot < a[i]) swap(a[i], a[--gt]);
+            else i++;
+        }
+    }
+
+    //in place median of medians, sorts each group of 5 and gathers the group medians at the start of the range
+    static N medianOfMedians(N *a, int lo, int hi) {
+        int groups = 0;
+        for (int g = lo; g < hi; g += 5) {
+            int groupEnd = std::min(g + 5, hi);
+            insertionSortRun(a, g, g + 1, groupEnd);
+            swap(a[lo + groups], a[(g + groupEnd - 1) / 2]);
+            groups++;
+        }
+        if (groups == 1) return a[lo];
+        return introSelect(a + lo, groups, groups / 2, true);
+    }
+
+    //returns the element that would be at 0-based index k of a[0, n) if it were sorted, partitioning a in place
+    //pivots are random unless worstCase is set or the partitions stop shrinking, then median of medians takes over
+    static N introSelect(N *a, int n, int k, bool worstCase) {
+        int lo = 0, hi = n;
+        int budget = 0; //random pivots allowed before switching, about 2 log2(n)
+        for (int m = n; m > 1; m >>= 1) budget += 2;
+        while (true) {
+            if (hi - lo <= 5) { //small enough to just sort
+                insertionSortRun(a, lo, lo + 1, hi);
+                return a[k];
             }
-        } 
+
+            N pivot = (worstCase || budget-- <= 0) ? medianOfMedians(a, lo, hi) : a[lo + rand() % (hi - lo)];
+            int lt, gt;
+            partition3(a, lo, hi, pivot, lt, gt);
+            if (k < lt) hi = lt;
+            else if (k < gt) return pivot;
+            else lo = gt;
+        }
     }
 
-    //recursive call of binary search
-    int binRecur(N a[], N x, int l, int r) {
-        //returns -1 if not found
-        if (r < l) return -1; 
+    //introSelect for several sorted 0-based ranks at once, found[i] gets the element at ranks[i]
+    //each partition is shared by every rank, and only the parts that still hold a requested rank are visited
+    static void multiSelectRange(N *a, int lo, int hi, const int *ranks, int count, N *found, int budget) {
+        while (count > 0) {
+            if (hi - lo <= 5) { //small enough to just sort
+                insertionSortRun(a, lo, lo + 1, hi);
+                for (int i = 0; i < count; i++) found[i] = a[ranks[i]];
+                return;
+            }
 
-        int mid = (l + r) / 2;
-        int index = (front + mid) % MAX;
-        if (x == a[index]) { //if x is found
-            return mid;
+            N pivot = (budget-- <= 0) ? medianOfMedians(a, lo, hi) : a[lo + rand() % (hi - lo)];
+            int lt, gt;
+            partition3(a, lo, hi, pivot, lt, gt);
+
+            //splitting the ranks into the ones below, inside and above the block equal to the pivot
+            int firstEqual = lower_bound(ranks, ranks + count, lt) - ranks;
+            int firstGreater = lower_bound(ranks, ranks + count, gt) - ranks;
+            for (int i = firstEqual; i < firstGreater; i++) found[i] = pivot;
+            multiSelectRange(a, lo, lt, ranks, firstEqual, found, budget);
+
+            //continuing with the greater part in this loop instead of recursing
+            lo = gt;
+            ranks += firstGreater;
+            found += firstGreater;
+            count -= firstGreater;
         }
-        else if (x < a[index]) { //if x is less that the value at the current index, recurse left
-            return binRecur(a, x, l, mid - 1);
+    }
+
+    //copy constructs the ring into raw scratch storage for the select routines, which partition the copy
+    N *selectScratch() {
+        N *scratch = allocate(size);
+        pair<segment, segment> spans = asSpans();
+        copyRange(scratch, spans.first.data, spans.first.length, typename is_trivially_copyable<N>::type());
+        copyRange(scratch + spans.first.length, spans.second.data, spans.second.length, typename is_trivially_copyable<N>::type());
+        return scratch;
+    }
+
+    //destroys and frees a scratch copy made by selectScratch
+    void freeScratch(N *scratch) {
+        for (int i = 0; i < size; i++) scratch[i].~N();
+        deallocate(scratch, size);
+    }
+
+    //branchless lower bound over the contiguous a[0, n), the compare picks the next base with a conditional move
+    static int branchlessLowerBound(const N *a, int n, const N &e) {
+        if (n == 0) return 0;
+        const N *base = a;
+        while (n > 1) {
+            int half = n / 2;
+            base = (base[half] < e) ? base + half : base;
+            n -= half;
         }
-        else { //if x is > the value at the current index, recurse right
-            return binRecur(a, x, mid + 1, r);
+        return (base - a) + (*base < e);
+    }
+
+    //branchless upper bound, same as branchlessLowerBound but moves past elements equal to e too
+    static int branchlessUpperBound(const N *a, int n, const N &e) {
+        if (n == 0) return 0;
+        const N *base = a;
+        while (n > 1) {
+            int half = n / 2;
+            base = (e < base[half]) ? base : base + half;
+            n -= half;
         }
+        return (base - a) + !(e < *base);
     }
 
-    //copies the array from front to back
-    void deepCopy(const CircularDynamicArray &src) { 
-        array = new N[src.MAX];
+    //Eytzinger slots that fit in one cache line, the search prefetches this many levels ahead
+    static const int prefetchStride = sizeof(N) >= 64 ? 1 : 64 / sizeof(N);
+
+    //lower bound through the Eytzinger index, descends 2k or 2k + 1 until falling off the tree then undoes the
+    //trailing right turns to find the answer
+    int eytzingerLowerBound(const N &e) {
+        int k = 1;
+        while (k <= indexedSize) {
+#ifdef __GNUC__
+            __builtin_prefetch(searchIndex + std::min((long long)k * prefetchStride, (long long)indexedSize));
+#endif
+            k = 2 * k + (searchIndex[k] < e);
+        }
+        k >>= __builtin_ffs(~k);
+        return k == 0 ? indexedSize : searchRank[k];
+    }
+
+    //fills the Eytzinger slots with an in-order walk of the implicit tree, next is the next sorted index to place
+    void fillSearchIndex(const N *sorted, int &next, int k) {
+        if (k > indexedSize) return;
+        fillSearchIndex(sorted, next, 2 * k);
+        new (&searchIndex[k]) N(sorted[next]);
+        searchRank[k] = next++;
+        fillSearchIndex(sorted, next, 2 * k + 1);
+    }
+
+    //frees the search index, called by everything that changes the array
+    void dropSearchIndex() {
+        if (searchIndex == nullptr) return;
+        for (int k = 1; k <= indexedSize; k++) searchIndex[k].~N();
+        deallocate(searchIndex, indexedSize + 1);
+        reboundAlloc<int> intAlloc(alloc);
+        allocator_traits<reboundAlloc<int> >::deallocate(intAlloc, searchRank, indexedSize + 1);
+        searchIndex = nullptr;
+        searchRank = nullptr;
+        indexedSize = 0;
+    }
+
+    //gets raw storage for n elements from the allocator without constructing any of them
+    N *allocate(int n) {
+        return traits::allocate(alloc, n);
+    }
+
+    //gives storage for n elements back to the allocator, the elements must already be destroyed
+    void deallocate(N *p, int n) {
+        if (p != nullptr) traits::deallocate(alloc, p, n);
+    }
+
+    //storage for a ring of n slots, the inline slots if they are big enough, the allocator otherwise
+    N *allocateRing(int n) {
+        return n <= InlineCap ? inlineSlots.data() : allocate(n);
+    }
+
+    //frees a ring of n slots from allocateRing, the inline slots are part of the object so there is nothing to free
+    void releaseRing(N *p, int n) {
+        if (n > InlineCap) deallocate(p, n);
+    }
+
+    //the array never gets smaller than the inline slots or the policy's minimum, so it only leaves the inline slots by
+    //growing and only goes back into them by shrinking from the heap
+    static int smallestCapacity() {
+        return InlineCap > Growth::minCapacity ? InlineCap : Growth::minCapacity;
+    }
+
+    //copy/move assignment only take the other array's allocator if the allocator asks for it
+    void adoptAllocator(const Alloc &a, std::true_type) { alloc = a; }
+    void adoptAllocator(const Alloc &, std::false_type) {}
+
+    //move assignment, the buffer can only be taken if it can be freed with this array's allocator afterwards
+    void moveAssign(CircularDynamicArray &src, std::true_type) {
+        adoptAllocator(src.alloc, std::true_type());
+        steal(src);
+    }
+    void moveAssign(CircularDynamicArray &src, std::false_type) {
+        if (alloc == src.alloc) steal(src);
+        else { //different allocators, the elements are copied into this array's own storage
+            deepCopy(src);
+            src.clear();
+        }
+    }
+
+    //destroys every live element, leaving the storage itself allocated
+    void destroyAll() {
+        for (int i = 0; i < size; i++) {
+            array[wrap(front + i)].~N();
+        }
+    }
+
+    //N is trivially copyable, so the ring is relocated as at most two contiguous memcpy segments
+    void unwrapInto(N *newArray, std::true_type) {
+        if (size == 0) return;
+        int firstLength = std::min(size, MAX - front); //front up to the end of the buffer, the rest wrapped to index 0
+        memcpy(newArray, array + front, firstLength * sizeof(N));
+        memcpy(newArray + firstLength, array, (size - firstLength) * sizeof(N));
+    }
+
+    //general version, move constructs each element into newArray and destroys the old one
+    void unwrapInto(N *newArray, std::false_type) {
+        for (int i = 0; i < size; i++) {
+            N &element = array[wrap(front + i)];
+            new (&newArray[i]) N(std::move(element));
+            element.~N();
+        }
+    }
+
+    //moves the live elements into newArray starting at index 0 and frees the old storage
+    void moveInto(N *newArray, int newMax) {
+        unwrapInto(newArray, typename is_trivially_copyable<N>::type());
+        releaseRing(array, MAX);
+
+        //updating attributes
+        array = newArray;
+        MAX = newMax;
+        front = 0;
+    }
+
+    //MAX after growing, a moved-from array has MAX 0 and starts again at the minimum capacity
+    int grownCapacity() {
+        return MAX == 0 ? smallestCapacity() : MAX * Growth::growthFactor;
+    }
+
+    //whether removing an element just took size below the shrink mark, the array then halves
+    //this is a crossing test so capacity set aside by reserve is kept until the array has grown into it
+    bool crossedShrinkMark() {
+        return !Growth::neverShrink && size + 1 == MAX / Growth::shrinkDivisor && MAX / 2 >= smallestCapacity();
+    }
+
+    //trivially copyable version, copies the (at most two) occupied segments of src into the same slots
+    void copySlots(const CircularDynamicArray &src, std::true_type) {
+        if (src.size == 0) return;
+        int firstLength = std::min(src.size, src.MAX - src.front);
+        memcpy(array + src.front, src.array + src.front, firstLength * sizeof(N));
+        memcpy(array, src.array, (src.size - firstLength) * sizeof(N));
+    }
+
+    //general version, copy constructs each element of src into the same slot
+    void copySlots(const CircularDynamicArray &src, std::false_type) {
         for(int i = src.front; i < src.front + src.size; i++) {
-            array[i % src.MAX] = src.array[i % src.MAX];
+            new (&array[i & (src.MAX - 1)]) N(src.array[i & (src.MAX - 1)]);
         }
+    }
+
+    //copies the live elements of src into the same slots of a new array
+    void deepCopy(const CircularDynamicArray &src) { 
+        array = allocateRing(src.MAX);
+        copySlots(src, typename is_trivially_copyable<N>::type());
 
-        //updating CDA attributes
+        //updating CDA attributes, the search index isn't copied
         size = src.size;
         front = src.front;
         MAX = src.MAX;
+        searchIndex = nullptr;
+        searchRank = nullptr;
+        indexedSize = 0;
+    }
+
+    //takes src's buffer and leaves src empty with no storage, a ring in src's inline slots can't be taken
+    //so its elements are moved into this array's inline slots instead
+    void steal(CircularDynamicArray &src) {
+        if (src.MAX > 0 && src.MAX <= InlineCap) {
+            array = inlineSlots.data();
+            src.unwrapInto(array, typename is_trivially_copyable<N>::type());
+            front = 0;
+        }
+        else {
+            array = src.array;
+            front = src.front;
+        }
+        size = src.size;
+        MAX = src.MAX;
+        searchIndex = src.searchIndex;
+        searchRank = src.searchRank;
+        indexedSize = src.indexedSize;
+        src.array = nullptr;
+        src.size = 0;
+        src.front = 0;
+        src.MAX = 0;
+        src.searchIndex = nullptr;
+        src.searchRank = nullptr;
+        src.indexedSize = 0;
+    }
+
+    //trivially copyable version, copies n elements from src into uninitialized slots with one memcpy
+    static void copyRange(N *dest, const N *src, int n, std::true_type) {
+        if (n > 0) memcpy(dest, src, n * sizeof(N));
+    }
+
+    //general version, copy constructs n elements from src into uninitialized slots
+    static void copyRange(N *dest, const N *src, int n, std::false_type) {
+        for (int i = 0; i < n; i++) {
+            new (&dest[i]) N(src[i]);
+        }
+    }
+
+    //trivially copyable version of the linearize slide, moves n elements from src down to dest (dest < src)
+    void slideDown(int dest, int src, int n, std::true_type) {
+        memmove(array + dest, array + src, n * sizeof(N));
+    }
+
+    //general version, slots below the old front are still unconstructed so they are move constructed rather than assigned
+    void slideDown(int dest, int src, int n, std::false_type) {
+        for (int i = 0; i < n; i++) {
+            if (dest + i < src) new (&array[dest + i]) N(std::move(array[src + i]));
+            else array[dest + i] = std::move(array[src + i]);
+        }
+        for (int i = std::max(dest + n, src); i < src + n; i++) { //destroying the vacated slots at the top of the buffer
+            array[i].~N();
+        }
+    }
+
+    //after a bulk pop, shrinks the same way a run of single delEnd/delFront calls would have
+    void shrinkAfterPop(int oldSize) {
+        if (Growth::neverShrink || oldSize < MAX / Growth::shrinkDivisor) return; //the shrink mark was never crossed
+        int newMax = MAX;
+        while (size < newMax / Growth::shrinkDivisor && newMax / 2 >= smallestCapacity()) newMax /= 2;
+        if (newMax != MAX) moveInto(allocateRing(newMax), newMax);
+    }
+
+    //trivially copyable elements are read over the raw slots by load, the general version default constructs them first
+    void constructForLoad(int, int, std::true_type) {}
+    void constructForLoad(int first, int n, std::false_type) {
+        for (int i = first; i < first + n; i++) {
+            new (&array[i]) N();
+        }
+    }
+
+    //fills an empty array from a forward range, reserving once since the length is known up front
+    template <class Iterator>
+    //a range longer than the ring can hold is cut down to its first maxCapacity elements, like the sized constructor
+    void fillFromRange(Iterator first, Iterator last, forward_iterator_tag) {
+        typename iterator_traits<Iterator>::difference_type n = distance(first, last);
+        if (n > maxCapacity) n = maxCapacity;
+        reserve((int)n);
+        for (int i = 0; i < (int)n; i++, ++first) {
+            new (&array[size++]) N(*first);
+        }
+    }
+
+    //fills an empty array from a single pass input range, one element at a time, stopping at maxCapacity elements
+    template <class Iterator>
+    void fillFromRange(Iterator first, Iterator last, input_iterator_tag) {
+        for (; first != last && size < maxCapacity; ++first) {
+            emplaceEnd(*first);
+        }
     }
 public:
-    //default constructor, makes an array of MAX 2 and size 0
-    CircularDynamicArray() { 
-        MAX = 2;
+    //random access iterator over the ring, pos is the distance from front so iterators compare and subtract like indices
+    template <class T>
+    class ringIterator {
+    private:
+        template <class> friend class ringIterator;
+        T *base;
+        int front;
+        int mask;
+        int pos;
+    public:
+        typedef random_access_iterator_tag iterator_category;
+        typedef typename remove_const<T>::type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        ringIterator() : base(nullptr), front(0), mask(0), pos(0) {}
+        ringIterator(T *b, int f, int m, int p) : base(b), front(f), mask(m), pos(p) {}
+
+        //lets an iterator convert to a const_iterator
+        template <class U, class = typename enable_if<is_convertible<U *, T *>::value>::type>
+        ringIterator(const ringIterator<U> &other) : base(other.base), front(other.front), mask(other.mask), pos(other.pos) {}
+
+        reference operator*() const { return base[(front + pos) & mask]; }
+        pointer operator->() const { return &base[(front + pos) & mask]; }
+        reference operator[](difference_type n) const { return base[(front + pos + (int)n) & mask]; }
+
+        ringIterator &operator++() { pos++; return *this; }
+        ringIterator operator++(int) { ringIterator old = *this; pos++; return old; }
+        ringIterator &operator--() { pos--; return *this; }
+        ringIterator operator--(int) { ringIterator old = *this; pos--; return old; }
+        ringIterator &operator+=(difference_type n) { pos += (int)n; return *this; }
+        ringIterator &operator-=(difference_type n) { pos -= (int)n; return *this; }
+        ringIterator operator+(difference_type n) const { return ringIterator(base, front, mask, pos + (int)n); }
+        ringIterator operator-(difference_type n) const { return ringIterator(base, front, mask, pos - (int)n); }
+        friend ringIterator operator+(difference_type n, const ringIterator &it) { return it + n; }
+
+        template <class U> difference_type operator-(const ringIterator<U> &other) const { return pos - other.pos; }
+        template <class U> bool operator==(const ringIterator<U> &other) const { return pos == other.pos; }
+        template <class U> bool operator!=(const ringIterator<U> &other) const { return pos != other.pos; }
+        template <class U> bool operator<(const ringIterator<U> &other) const { return pos < other.pos; }
+        template <class U> bool operator>(const ringIterator<U> &other) const { return pos > other.pos; }
+        template <class U> bool operator<=(const ringIterator<U> &other) const { return pos <= other.pos; }
+        template <class U> bool operator>=(const ringIterator<U> &other) const { return pos >= other.pos; }
+    };
+    typedef ringIterator<N> iterator;
+    typedef ringIterator<const N> const_iterator;
+
+    //a contiguous run of elements inside the buffer
+    struct segment {
+        N *data;
+        int length;
+        N *begin() const { return data; }
+        N *end() const { return data + length; }
+    };
+
+    //default constructor, makes an array of size 0 with the policy's minimum capacity (2 by default), or the inline
+    //capacity if that is larger
+    CircularDynamicArray() : CircularDynamicArray(Alloc()) {}
+
+    //empty array whose storage comes from a
+    explicit CircularDynamicArray(const Alloc &a) : alloc(a) { 
+        MAX = smallestCapacity();
         size = 0;
-        array = new N[MAX];
+        array = allocateRing(MAX);
         front = 0;
+        searchIndex = nullptr;
+        searchRank = nullptr;
+        indexedSize = 0;
     }
 
-    //constructor, array of MAX and size s
-    CircularDynamicArray(int s) { 
-        MAX = s;
+    //constructor, array of size s with value-initialized elements, MAX is s rounded up to a power of two
+    //(and at least the inline capacity), s is cut down to maxCapacity and a negative s gives an empty array
+    CircularDynamicArray(int s, const Alloc &a = Alloc()) : alloc(a) {
+        if (s < 0) s = 0;
+        if (s > maxCapacity) s = maxCapacity;
+        MAX = std::max(roundUpPow2(s, maxCapacity), InlineCap);
         size = s;
-        array = new N[MAX];
+        array = allocateRing(MAX);
         front = 0;
+        searchIndex = nullptr;
+        searchRank = nullptr;
+        indexedSize = 0;
+        for (int i = 0; i < size; i++) {
+            new (&array[i]) N();
+        }
     } 
+    //constructor, array holding a copy of the range [first, last)
+    template <class Iterator, class = typename enable_if<!is_integral<Iterator>::value>::type>
+    CircularDynamicArray(Iterator first, Iterator last, const Alloc &a = Alloc()) : alloc(a) {
+        MAX = smallestCapacity();
+        size = 0;
+        array = allocateRing(MAX);
+        front = 0;
+        searchIndex = nullptr;
+        searchRank = nullptr;
+        indexedSize = 0;
+        fillFromRange(first, last, typename iterator_traits<Iterator>::iterator_category());
+    }
     ~CircularDynamicArray() { //destructor
-        delete[] array;
+        dropSearchIndex();
+        destroyAll();
+        releaseRing(array, MAX);
     }
-    CircularDynamicArray(const CircularDynamicArray &src) { //copy constructor
+    CircularDynamicArray(const CircularDynamicArray &src) : alloc(traits::select_on_container_copy_construction(src.alloc)) { //copy constructor
         deepCopy(src);
     } 
+    CircularDynamicArray(CircularDynamicArray &&src) noexcept(nothrowSteal) : alloc(std::move(src.alloc)) { //move constructor
+        steal(src);
+    }
     CircularDynamicArray &operator=(const CircularDynamicArray &src) { //copy assignment operator
         if (this != &src) {
-            delete[] array;
+            dropSearchIndex();
+            destroyAll();
+            releaseRing(array, MAX);
+            adoptAllocator(src.alloc, typename traits::propagate_on_container_copy_assignment::type());
             deepCopy(src);
         }
         return *this;
     }
+    CircularDynamicArray &operator=(CircularDynamicArray &&src) noexcept(nothrowMoveAssign) { //move assignment operator
+        if (this != &src) {
+            dropSearchIndex();
+            destroyAll();
+            releaseRing(array, MAX);
+            moveAssign(src, typename traits::propagate_on_container_move_assignment::type());
+        }
+        return *this;
+    }
+
+    typedef Alloc allocator_type;
+    Alloc getAllocator() const {
+        return alloc;
+    }
 
     //returns the value from the array relative to the front
     N &operator[](int index) { 
-        if (index < 0 || index >= MAX) return dummyElement;
-        return array[(front + index) % MAX];
+        if (index < 0 || index >= size) return dummyElement;
+        return array[wrap(front + index)];
     }
 
     void addEnd(N v) {
-        if (size == 0) { //empty array
-            array[0] = v;
-            size++;
-        }
-        else if (size == MAX) { //full array, resizes to a new array double the capacity
-            N *newArray = new N[MAX * 2];
-            for (int i = 0; i < size; i++) { //starts copying at the front of the old array
-                newArray[i] = array[(front + i) % MAX];
-            }
-            delete[] array;
+        emplaceEnd(std::move(v));
+    }
 
-            //updating the attributes and pointing the array to the newArray
-            MAX *= 2;
-            front = 0;
-            array = newArray;
+    void addFront(N v) {
+        emplaceFront(std::move(v));
+    }
 
-            //inserting v into the back of the array
-            array[front + size] = v;
-            size++;
+    //constructs an element in place at the back of the array
+    template <class... Args>
+    void emplaceEnd(Args&&... args) {
+        dropSearchIndex();
+        if (size == 0) { //empty array, front may have drifted so it is reset
+            front = 0;
+        }
+        if (size == MAX) { //full array, resizes to a new array double the capacity
+            //the new element is built first in case args refers to an element of this array
+            int newMax = grownCapacity();
+            N *newArray = allocateRing(newMax);
+            new (&newArray[size]) N(std::forward<Args>(args)...);
+            moveInto(newArray, newMax);
         }
-        else { //array is neither full nor empty
-            array[(front + size) % MAX] = v;
-            size++;
+        else { //array is not full
+            new (&array[wrap(front + size)]) N(std::forward<Args>(args)...);
         }
+        size++;
     }
 
-    void addFront(N v) {
-        if (size == 0) { //empty array
-            array[0] = v;
-            size++;
-        }
-        else if (size == MAX) { //array is full, resizing to a new array double the size
-            N *newArray = new N[MAX * 2];
-            for (int i = 0; i < size; i++) { //copying starting at the front
-                newArray[i] = array[(front + i) % MAX];
-            }
-            delete[] array;
-
-            //updating attributes, front will be at the back of the array
-            MAX *= 2;
+    //constructs an element in place at the front of the array
+    template <class... Args>
+    void emplaceFront(Args&&... args) {
+        dropSearchIndex();
+        if (size == 0) { //empty array, front may have drifted so it is reset
+            front = 0;
+        }
+        if (size == MAX) { //array is full, resizing to a new array double the size
+            //the new element goes at the back of the new array and front wraps around to it
+            int newMax = grownCapacity();
+            N *newArray = allocateRing(newMax);
+            new (&newArray[newMax - 1]) N(std::forward<Args>(args)...);
+            moveInto(newArray, newMax);
             front = MAX - 1;
-            array = newArray;
-
-            //inserting v into the front of the array
-            array[front] = v;
-            size++;
         }
-        else { //array is neither empty nor full
-            front = (front - 1 + MAX) % MAX; //updating where the front pointer is
-            array[front] = v;
-            size++;
+        else { //array is not full
+            front = wrap(front - 1); //updating where the front pointer is
+            new (&array[front]) N(std::forward<Args>(args)...);
         }
+        size++;
     }
 
     void delEnd() {
         if (size == 0) return; //if the array is empty, there is nothing to delete
-        else if (size == (MAX / 4)) { //if the array is less than 1/4th the capacity, resize to a smaller array
-            size--;
-            N *newArray = new N[MAX / 2];
-            for (int i = 0; i < size; i++) { //copying elements
-                newArray[i] = array[(front + i) % MAX];
-            }
-            delete[] array;
-
-            //updating attributes
-            MAX /= 2;
-            front = 0;
-            array = newArray;
-        }
-        else { //arrray is neither empty nor at 1/4th capacity
-            size = (size - 1 + MAX) % MAX; //decrement the size pointer to "delete" from back
+        dropSearchIndex();
+        size--;
+        array[wrap(front + size)].~N();
+        if (crossedShrinkMark()) { //if the array is less than 1/4th the capacity (by default), resize to a smaller array
+            moveInto(allocateRing(MAX / 2), MAX / 2);
         }
     }
 
     void delFront() {
         if (size == 0) return; //if the array is empty, there is nothing to delete
-        else if (size == (MAX / 4)) { //if the array is less than 1/4th the capacity, resize to a smaller array
-            front = (front + 1) % MAX;
-            N *newArray = new N[MAX / 2];
-            for (int i = 0; i < size; i++) { //copying elements
-                newArray[i] = array[(front + i) % MAX];
-            }
-            delete[] array;
+        dropSearchIndex();
+        array[front].~N();
+        front = wrap(front + 1);
+        size--;
+        if (crossedShrinkMark()) { //if the array is less than 1/4th the capacity (by default), resize to a smaller array
+            moveInto(allocateRing(MAX / 2), MAX / 2);
+        }
+    }
 
-            //updating attributes
-            MAX /= 2;
-            front = 0;
-            array = newArray;
+    //makes sure the array can hold n elements without another resize, returns false and leaves the array as it is if
+    //n is more than the ring can ever hold
+    bool reserve(int n) {
+        if (n > maxCapacity) return false;
+        if (n > MAX) moveInto(allocateRing(roundUpPow2(n, maxCapacity)), roundUpPow2(n, maxCapacity));
+        return true;
+    }
+
+    //shrinks the capacity to the smallest power of two that holds every element, but not below the minimum capacity
+    void shrinkToFit() {
+        int fit = roundUpPow2(std::max(size, smallestCapacity()), maxCapacity);
+        if (fit < MAX) moveInto(allocateRing(fit), fit);
+    }
+
+    //grows the ring to fit n more elements and copies src into the new ring, onto its back or its front, before the
+    //old ring is freed, so src may point into this array like emplaceEnd's args
+    void growAndCopy(const N *src, int n, bool atFront) {
+        int newMax = roundUpPow2(size + n, maxCapacity);
+        N *newArray = allocateRing(newMax);
+        copyRange(newArray + (atFront ? newMax - n : size), src, n, typename is_trivially_copyable<N>::type());
+        moveInto(newArray, newMax);
+        if (atFront) front = newMax - n;
+        size += n;
+    }
+
+    //copies count elements from src onto the back, resizing at most once, returns false and copies nothing if the
+    //array would end up with more than maxCapacity elements, src may point into this array
+    bool appendRange(const N *src, size_t count) {
+        if (count > (size_t)(maxCapacity - size)) return false;
+        int n = (int)count;
+        dropSearchIndex();
+        if (size == 0) front = 0;
+        if (size + n > MAX) {
+            growAndCopy(src, n, false);
+            return true;
+        }
+
+        //the free slots after the back are at most two segments: up to the end of the buffer, then from index 0
+        int start = wrap(front + size);
+        int firstLength = std::min(n, MAX - start);
+        copyRange(array + start, src, firstLength, typename is_trivially_copyable<N>::type());
+        copyRange(array, src + firstLength, n - firstLength, typename is_trivially_copyable<N>::type());
+        size += n;
+        return true;
+    }
+
+    //copies count elements from src onto the front, keeping their order, resizing at most once, returns false and
+    //copies nothing if the array would end up with more than maxCapacity elements, src may point into this array
+    bool prependRange(const N *src, size_t count) {
+        if (count > (size_t)(maxCapacity - size)) return false;
+        int n = (int)count;
+        dropSearchIndex();
+        if (size == 0) front = 0;
+        if (size + n > MAX) {
+            growAndCopy(src, n, true);
+            return true;
+        }
+
+        //src[0] becomes the new front, the segment split is the same as appendRange
+        int start = wrap(front - n);
+        int firstLength = std::min(n, MAX - start);
+        copyRange(array + start, src, firstLength, typename is_trivially_copyable<N>::type());
+        copyRange(array, src + firstLength, n - firstLength, typename is_trivially_copyable<N>::type());
+        front = start;
+        size += n;
+        return true;
+    }
+
+    //removes n elements from the front, or all of them if there are fewer than n
+    void popFront(int n) {
+        int oldSize = size;
+        dropSearchIndex();
+        n = std::min(std::max(n, 0), size);
+        for (int i = 0; i < n; i++) {
+            array[wrap(front + i)].~N();
         }
-        else { //arrray is neither empty nor at 1/4th capacity
-            front = (front + 1) % MAX; //decrementing the front
-            size--;
+        front = wrap(front + n);
+        size -= n;
+        shrinkAfterPop(oldSize);
+    }
+
+    //removes n elements from the back, or all of them if there are fewer than n
+    void popEnd(int n) {
+        int oldSize = size;
+        dropSearchIndex();
+        n = std::min(std::max(n, 0), size);
+        size -= n;
+        for (int i = 0; i < n; i++) {
+            array[wrap(front + size + i)].~N();
         }
+        shrinkAfterPop(oldSize);
+    }
+
+    //iterators are invalidated by anything that resizes or linearizes the array
+    iterator begin() { return iterator(array, front, MAX - 1, 0); }
+    iterator end() { return iterator(array, front, MAX - 1, size); }
+    const_iterator begin() const { return const_iterator(array, front, MAX - 1, 0); }
+    const_iterator end() const { return const_iterator(array, front, MAX - 1, size); }
+
+    //returns the (at most two) contiguous segments of the ring in order from the front, second is empty if the ring doesn't wrap
+    pair<segment, segment> asSpans() {
+        int firstLength = std::min(size, MAX - front);
+        segment first = {array + front, firstLength};
+        segment second = {array, size - firstLength};
+        return make_pair(first, second);
+    }
+
+    //rotates the ring in place so front is at index 0 and the elements form one contiguous block
+    segment linearize() {
+        int firstLength = std::min(size, MAX - front);
+        int wrapped = size - firstLength;
+        if (wrapped == 0) { //already contiguous, only the front moves
+            if (size == 0) front = 0;
+            segment whole = {array + front, size};
+            return whole;
+        }
+
+        //slides the front segment down to sit right after the wrapped one, then rotates [wrapped | front] to [front | wrapped]
+        if (front != wrapped) slideDown(wrapped, front, firstLength, typename is_trivially_copyable<N>::type());
+        rotate(array, array + wrapped, array + size);
+        front = 0;
+        segment whole = {array, size};
+        return whole;
     }
 
     int length() {
@@ -327,111 +1267,357 @@ public:
 
     //resets the array to be "empty"
     void clear() { 
-        delete[] array;
-        MAX = 2;
+        dropSearchIndex();
+        destroyAll();
+        releaseRing(array, MAX);
+        MAX = smallestCapacity();
         size = 0;
         front = 0;
-        array = new N[MAX];
+        array = allocateRing(MAX);
+    }
+
+    //writes the array to out in the BinaryIO format, front first, returns false if the stream failed
+    bool save(ostream &out) {
+        writeBinaryHeader(out, "CDAR", binaryCodec<N>::fixedSize, 0, size);
+        pair<segment, segment> spans = asSpans();
+        binaryCodec<N>::write(out, spans.first.data, spans.first.length);
+        binaryCodec<N>::write(out, spans.second.data, spans.second.length);
+        return out.good();
     }
 
+    //replaces the contents with an array written by save, returns false if in doesn't hold one
+    //the elements are read straight into the linear ring, a single read for trivially copyable types when the stream
+    //is seen to hold them all, otherwise the ring grows a binaryReadChunk at a time as they arrive, so a corrupt count
+    //fails at the end of the stream instead of reserving room for it up front
+    bool load(istream &in) {
+        uint64_t count;
+        if (!readBinaryHeader(in, "CDAR", binaryCodec<N>::fixedSize, 0, count) || count > (uint64_t)maxCapacity) return false;
+        dropSearchIndex();
+        destroyAll();
+        size = 0;
+        front = 0;
+        uint64_t step = binaryReadStep<N>(in, count);
+        while ((uint64_t)size < count) {
+            int n = (int)(count - size < step ? count - size : step);
+            reserve(size + n);
+            constructForLoad(size, n, typename is_trivially_copyable<N>::type());
+            size += n;
+            if (!binaryCodec<N>::read(in, array + size - n, n)) { //truncated stream, the array is left empty
+                clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //returns the kth smallest element (1-based) using quickselect with random pivots on a scratch copy
     N QuickSelect(int k) {
         //error checking for k values
         if (k < 1 || k > size) return -1; 
 
-        //a random number between 0 and the size of the array
-        int randIndex = rand() % size; 
+        N *scratch = selectScratch();
+        N result = introSelect(scratch, size, k - 1, false);
+        freeScratch(scratch);
+        return result;
+    } 
 
-        //accesses this pivot with an offset from the front
-        N pivot = array[(front + randIndex) % MAX]; 
-        vector<N> L, E, G;
+    //performs the select algorithm in worst case O(n) time using medians of medians, on a scratch copy
+    N WCSelect(int k) { 
+        if (k < 1 || k > size) return -1;
 
-        //start adding elements to the less than/equal to/greater than lists
-        for (int i = front; i < front + size; i++) { 
-            N element = array[i % MAX];
-            if (element < pivot) L.push_back(element);
-            else if (element == pivot) E.push_back(element);
-            else G.push_back(element);
-        }
-        if (k <= L.size()) return quickSelect(L, k);
-        else if (k <= L.size() + E.size()) return pivot;
-        else return quickSelect(G, k - L.size() - E.size());
+        N *scratch = selectScratch();
+        N result = introSelect(scratch, size, k - 1, true);
+        freeScratch(scratch);
+        return result;
     } 
 
-    //performs the select algorithm in worst case O(n) time using medians of medians
-    N WCSelect(int k) { 
+    //QuickSelect for count ranks at once, returns the kth smallest for each k in ks, in the same order as ks
+    //partitions a single scratch copy, so it costs about one selection rather than count of them
+    CircularDynamicArray multiSelect(const int *ks, int count) {
+        if (count <= 0) return CircularDynamicArray(alloc);
+        CircularDynamicArray results(count, alloc);
+
+        //sorting the valid ranks (0-based) while remembering where each one was asked for
+        scratchVector<pair<int, int> > wanted(alloc);
+        wanted.reserve(count);
+        for (int i = 0; i < count; i++) {
+            if (ks[i] < 1 || ks[i] > size) results[i] = -1; //error value for bad k values, same as QuickSelect
+            else wanted.push_back(make_pair(ks[i] - 1, i));
+        }
+        if (wanted.empty()) return results;
+        sort(wanted.begin(), wanted.end());
+        scratchVector<int> ranks(alloc);
+        ranks.reserve(wanted.size());
+        for (size_t i = 0; i < wanted.size(); i++) ranks.push_back(wanted[i].first);
+
+        int budget = 0; //random pivots allowed before switching to median of medians, same as introSelect
+        for (int m = size; m > 1; m >>= 1) budget += 2;
+        CircularDynamicArray found((int)ranks.size(), alloc);
+        N *scratch = selectScratch();
+        multiSelectRange(scratch, 0, size, &ranks[0], (int)ranks.size(), &found[0], budget);
+        freeScratch(scratch);
+
+        for (size_t i = 0; i < wanted.size(); i++) {
+            results[wanted[i].second] = found[(int)i];
+        }
+        return results;
+    }
+
+    //QuickSelect without the copy, partitions the array itself so afterwards the kth smallest is at index k - 1
+    //with nothing larger before it and nothing smaller after it
+    N QuickSelectInPlace(int k) {
         if (k < 1 || k > size) return -1;
+        dropSearchIndex();
+        return introSelect(linearize().data, size, k - 1, false);
+    }
+
+    //stable sort, a bottom-up natural merge sort on the linearized ring using a single scratch buffer
+    //large integral arrays are radix sorted instead since the result is the same
+    void stableSort() { 
+        if (size < 2) return;
+        dropSearchIndex();
+        sortByType(typename is_integral<N>::type());
+    }
 
-        //stores a collection of partitions, the size of this collection is used to determine when to stop 
-        vector<int> partitions; 
-        for (int i = 0; i < size; i += 5) {
-            partitions.push_back(i);
-        }
-
-        vector<N> medians;
-
-        //for each group of 5, run insertion sort on it 
-        int i;
-        for (i = 0; i < partitions.size(); i++) {
-            int low = partitions.at(i);
-            int high = (i + 1) * 5;
-            if (size % 5 != 0 && i == partitions.size() - 1) break;
-            InsertionSort(array, low, high);
-            
-            //select median of each group
-            medians.push_back(array[(( (front + high - 1) + (front + low) ) / 2) % MAX]);
-        }
-        
-        //if the size is not divisible by 5, one more insertionSort call needs to be performed on the last bit of the array
-        if (size % 5 != 0) { 
-            int low = partitions.at(i);
-            int high = size;
-            InsertionSort(array, low, high);
-            
-            if (low == high) {
-                medians.push_back(array[(front + low) % MAX]);
+    //stable LSD radix sort one byte at a time on the key from radixKey<N>, works for integers, floats, doubles
+    //and any struct with a radixKey specialization, passes where every element has the same byte are skipped
+    void radixSort() {
+        typedef radixKey<N> keyOf;
+        typedef typename keyOf::type keyType;
+        const int passes = sizeof(keyType);
+        if (size < 2) return;
+        dropSearchIndex();
+        N *a = linearize().data;
+
+        //counting every pass's digits in one scan
+        scratchVector<int> counts(passes * 256, 0, alloc);
+        for (int i = 0; i < size; i++) {
+            keyType k = keyOf::get(a[i]);
+            for (int p = 0; p < passes; p++) {
+                counts[p * 256 + ((k >> (8 * p)) & 255)]++;
             }
-            else { //selects median
-                medians.push_back(array[(( (front + high - 1) + (front + low) ) / 2) % MAX]);
+        }
+
+        //passes ping-pong between a and buffer, the first write into buffer constructs its elements
+        N *buffer = allocate(size);
+        bool bufferLive = false;
+        N *src = a, *dst = buffer;
+        keyType firstKey = keyOf::get(a[0]);
+        for (int p = 0; p < passes; p++) {
+            int *count = &counts[p * 256];
+            if (count[(firstKey >> (8 * p)) & 255] == size) continue; //every element has the same digit
+
+            //turning the counts into starting offsets
+            int offset[256];
+            int total = 0;
+            for (int d = 0; d < 256; d++) {
+                offset[d] = total;
+                total += count[d];
             }
+
+            bool construct = (dst == buffer && !bufferLive);
+            for (int i = 0; i < size; i++) {
+                int d = (keyOf::get(src[i]) >> (8 * p)) & 255;
+                if (construct) new (&dst[offset[d]++]) N(std::move(src[i]));
+                else dst[offset[d]++] = std::move(src[i]);
+            }
+            if (dst == buffer) bufferLive = true;
+            swap(src, dst);
         }
 
-        N pivot = medianOfMedians(medians);
-        vector<N> L, E, G;
-        for (int i = front; i < front + size; i++) {
-            N element = array[i % MAX];
-            if (element < pivot) L.push_back(element);
-            else if (element == pivot) E.push_back(element);
-            else G.push_back(element);
+        //moving the result back if the last pass wrote into buffer, then cleaning up buffer
+        if (src == buffer) move(buffer, buffer + size, a);
+        if (bufferLive) {
+            for (int i = 0; i < size; i++) buffer[i].~N();
         }
-        if (k <= L.size()) return select(L, k);
-        else if (k <= L.size() + E.size()) return pivot;
-        else return select(G, k - L.size() - E.size());
-    } 
-    
-    //contains first call of mergeSort, serves as a bridge between circular array and regular arrays
-    void stableSort() { 
-        N a1[size / 2];
-        N a2[size - (size / 2)];
-        for (int i = 0; i < size / 2; i++)
-            a1[i] = array[(front + i) % MAX];
-        for (int i = size / 2; i < size; i++)
-            a2[i-size/2] = array[(front + i) % MAX];
-        mergeSort(a1, size/2);
-        mergeSort(a2, size-size/2);
-        mergeIntoParent(array, a1, a2, size); 
+        deallocate(buffer, size);
+    }
+
+    //stableSort split across threads, the result is identical to stableSort
+    //each thread sorts one chunk, then neighbouring chunks are merged in passes with every pass split evenly across
+    //the threads by co-ranking, so a thread merges its share of the output even on the final pass
+    void parallelStableSort(int threads) {
+        if (threads < 1) threads = std::max(1, (int)thread::hardware_concurrency());
+        threads = std::min(threads, size / 4096); //chunks smaller than this aren't worth a thread
+        dropSearchIndex();
+        if (threads <= 1) {
+            stableSort();
+            return;
+        }
+
+        N *a = linearize().data;
+        N *scratch = allocate(size);
+        scratchVector<int> bounds(alloc);
+        for (int t = 0; t <= threads; t++) {
+            bounds.push_back((int)((long long)size * t / threads));
+        }
+
+        //sorting the chunks, each one uses its own slice of scratch and of runStarts, so the worker threads never
+        //touch the allocator, which may not be thread safe
+        scratchVector<int> runStarts(runSlots(size) + 2 * threads, 0, alloc);
+        scratchVector<thread> workers(alloc);
+        for (int t = 0, slot = 0; t < threads; t++) {
+            int chunk = bounds[t + 1] - bounds[t];
+            workers.push_back(thread(runMergeSort, a + bounds[t], chunk, scratch + bounds[t], &runStarts[slot]));
+            slot += runSlots(chunk);
+        }
+        for (int t = 0; t < threads; t++) workers[t].join();
+
+        //merging passes ping-pong between a and scratch, the first write into scratch constructs its elements
+        N *src = a, *dst = scratch;
+        bool scratchLive = false;
+        while (bounds.size() > 2) {
+            bool construct = (dst == scratch && !scratchLive);
+            scratchVector<mergePiece> pieces(alloc);
+            scratchVector<int> firstPiece(alloc);
+            for (int t = 0; t < threads; t++) {
+                int k0 = (int)((long long)size * t / threads), k1 = (int)((long long)size * (t + 1) / threads);
+                firstPiece.push_back(pieces.size());
+                planMergePass(src, dst, bounds, k0, k1, pieces);
+            }
+            firstPiece.push_back(pieces.size());
+            workers.clear();
+            for (int t = 0; t < threads; t++) {
+                workers.push_back(thread(mergePieces, pieces.data() + firstPiece[t], firstPiece[t + 1] - firstPiece[t], construct));
+            }
+            for (int t = 0; t < threads; t++) workers[t].join();
+            if (dst == scratch) scratchLive = true;
+
+            //every other bound survives, the last one is always the end of the array
+            scratchVector<int> merged(alloc);
+            for (int r = 0; r + 1 < (int)bounds.size(); r += 2) merged.push_back(bounds[r]);
+            merged.push_back(size);
+            bounds.swap(merged);
+            swap(src, dst);
+        }
+
+        //moving the result back if the last pass wrote into scratch, then cleaning up scratch
+        if (src == scratch) move(scratch, scratch + size, a);
+        if (scratchLive) {
+            for (int i = 0; i < size; i++) scratch[i].~N();
+        }
+        deallocate(scratch, size);
     }
 
     //performs a linear search starting at the front; returns the index
+    //scans the (at most two) contiguous segments of the ring, with SIMD for 4 and 8 byte arithmetic types
     int linearSearch(N e) { 
-        //used to track index in reference to the distance from front
-        int userIndex = 0; 
-        for(int i = front; i < front + size; i++) {
-            if (array[i % MAX] == e) return userIndex;
-            userIndex++;
-        }
-        return -1;
+        pair<segment, segment> spans = asSpans();
+        int i = ringScan<N>::find(spans.first.data, spans.first.length, e);
+        if (i != -1) return i;
+        i = ringScan<N>::find(spans.second.data, spans.second.length, e);
+        return (i == -1) ? -1 : spans.first.length + i;
     } 
+
+    //number of elements equal to e
+    int count(N e) {
+        pair<segment, segment> spans = asSpans();
+        return ringScan<N>::count(spans.first.data, spans.first.length, e) + ringScan<N>::count(spans.second.data, spans.second.length, e);
+    }
+
+    //smallest element, returns the dummy element if the array is empty
+    N min() {
+        if (size == 0) return dummyElement;
+        pair<segment, segment> spans = asSpans();
+        N m = ringScan<N>::minimum(spans.first.data, spans.first.length);
+        if (spans.second.length > 0) {
+            N m2 = ringScan<N>::minimum(spans.second.data, spans.second.length);
+            if (m2 < m) m = m2;
+        }
+        return m;
+    }
+
+    //largest element, returns the dummy element if the array is empty
+    N max() {
+        if (size == 0) return dummyElement;
+        pair<segment, segment> spans = asSpans();
+        N m = ringScan<N>::maximum(spans.first.data, spans.first.length);
+        if (spans.second.length > 0) {
+            N m2 = ringScan<N>::maximum(spans.second.data, spans.second.length);
+            if (m < m2) m = m2;
+        }
+        return m;
+    }
+
+    //sum of every element, starting from a value-initialized N
+    N sum() {
+        pair<segment, segment> spans = asSpans();
+        return ringScan<N>::sum(spans.first.data, spans.first.length) + ringScan<N>::sum(spans.second.data, spans.second.length);
+    }
+
+    //binary search of a sorted array, returns the index of an element equal to e or -1 if there isn't one
     int binSearch(N e) {
-        return binRecur(array, e, 0, size - 1);
-    }      
+        int i = lowerBound(e);
+        if (i < size && (*this)[i] == e) return i;
+        return -1;
+    }
+
+    //index of the first element not less than e in a sorted array, or length() if every element is less
+    int lowerBound(const N &e) {
+        if (searchIndex != nullptr) return eytzingerLowerBound(e);
+        return branchlessLowerBound(linearize().data, size, e);
+    }
+
+    //index of the first element greater than e in a sorted array, or length() if there isn't one
+    int upperBound(const N &e) {
+        return branchlessUpperBound(linearize().data, size, e);
+    }
+
+    //binSearch for count keys, out[i] gets the result for keys[i]
+    //searches run in groups that step together one level at a time, so their cache misses overlap
+    void binSearchMany(const N *keys, int count, int *out) {
+        const int group = 8;
+        N *a = linearize().data;
+        for (int g = 0; g < count; g += group) {
+            int m = std::min(group, count - g);
+            int pos[group];
+            if (searchIndex != nullptr) { //descending the Eytzinger tree for every key in the group
+                for (int j = 0; j < m; j++) pos[j] = 1;
+                for (int level = 1; level <= indexedSize; level <<= 1) {
+                    for (int j = 0; j < m; j++) {
+                        if (pos[j] > indexedSize) continue;
+#ifdef __GNUC__
+                        __builtin_prefetch(searchIndex + std::min((long long)pos[j] * prefetchStride, (long long)indexedSize));
+#endif
+                        pos[j] = 2 * pos[j] + (searchIndex[pos[j]] < keys[g + j]);
+                    }
+                }
+                for (int j = 0; j < m; j++) {
+                    int k = pos[j] >> __builtin_ffs(~pos[j]);
+                    pos[j] = (k == 0) ? indexedSize : searchRank[k];
+                }
+            }
+            else { //halving every key's range together over the sorted buffer
+                for (int j = 0; j < m; j++) pos[j] = 0;
+                int n = size;
+                while (n > 1) {
+                    int half = n / 2;
+                    for (int j = 0; j < m; j++) {
+                        pos[j] = (a[pos[j] + half] < keys[g + j]) ? pos[j] + half : pos[j];
+                    }
+                    n -= half;
+                }
+                for (int j = 0; j < m; j++) {
+                    if (size > 0 && a[pos[j]] < keys[g + j]) pos[j]++;
+                }
+            }
+            for (int j = 0; j < m; j++) {
+                out[g + j] = (pos[j] < size && a[pos[j]] == keys[g + j]) ? pos[j] : -1;
+            }
+        }
+    }
+
+    //builds an Eytzinger copy of the sorted array that lowerBound, binSearch and binSearchMany use from then on
+    //it is a snapshot, member functions that change the array drop it, writes through operator[] or iterators don't,
+    //so call this again after changing elements that way
+    void buildSearchIndex() {
+        dropSearchIndex();
+        N *sorted = linearize().data;
+        indexedSize = size;
+        searchIndex = allocate(size + 1);
+        reboundAlloc<int> intAlloc(alloc);
+        searchRank = allocator_traits<reboundAlloc<int> >::allocate(intAlloc, size + 1);
+        int next = 0;
+        fillSearchIndex(sorted, next, 1);
+    }
 };
\ No newline at end of file
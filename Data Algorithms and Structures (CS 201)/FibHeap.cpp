@@ -43,8 +43,9 @@ private:
         int degree;
 
         //calculating the upper limit on the numebr of trees in the root list
-        float temp = (log(numNodes) / log(2));
-        int upperBound = temp;
+        //cuts from decreaseKey let a rank reach log base phi of numNodes, not just log base 2
+        float temp = (log(numNodes) / log((1 + sqrt(5)) / 2));
+        int upperBound = temp + 1;
         FibHeapNode<key> *A[upperBound + 1]; //array used for consolidation
         
         //initializing all the pointers to nullptr
@@ -55,26 +56,30 @@ private:
         FibHeapNode<key> *node1 = head; //starts at head
         FibHeapNode<key> *node2;
         FibHeapNode<key> *node3;
-        //FibHeapNode<key> *node4 = node1;
 
+        //counting the roots first, linking reorders the root list so walking it until head comes back around can
+        //stop early and drop trees
+        int numRoots = 0;
         do {
+            numRoots++;
+            node1 = node1->right;
+        } while (node1 != head);
+
+        FibHeapNode<key> *nextRoot = head;
+        for (int r = 0; r < numRoots; r++) {
+            node1 = nextRoot;
+            nextRoot = node1->right; //saved before linking, a root not visited yet is never linked away
             degree = node1->rank;
-            //node4 = node4->right;
-            //cout << "Cur node is: " << node1->nodeKey << endl;
 
             //using the A array to check for numerous trees of a certain degree
             while(A[degree] != nullptr) {
                 node2 = A[degree];
-                if (node2 == node1) break;
                 if (node1->nodeKey > node2->nodeKey) { //swap node1 and node2 if node1 is pointing to the largest value
                     node3 = node1;
                     node1 = node2;
                     node2 = node3;
                 }
-                if (node2 == head) {
-                    head = node1;
-                }
-                
+
                 link(node2, node1); //makes node2 a child of node1
 
                 //updating A array to reflect the linking operation making a larger tree
@@ -83,8 +88,7 @@ private:
             }
             //Assigning A list with appropriate sized tree
             A[degree] = node1;
-            node1 = node1->right;
-        } while (node1 != head);
+        }
 
         min = nullptr;
         head = nullptr;
@@ -160,8 +164,9 @@ private:
             y->child = x->right;
         }
 
-        //insert x into the root list and unmark it
+        //insert x into the root list and unmark it, it is a root now so it has no parent
         nodeInsert(x);
+        x->parent = nullptr;
         x->isMarked = false;
 
         //decrement y's rank
@@ -1,89 +1,691 @@
 #include <iostream>
+#include <vector>
+#include <functional>
+#include <type_traits>
 //#include "CircularDynamicArray.cpp"
+#include "BinaryIO.cpp"
 using namespace std;
 
-template<typename key>
+//min heap where every node has D children (D = 2 is the usual binary heap), wider heaps are shallower so extractMin
+//takes fewer dependent cache misses, and with a cache line aligned buffer each group of D siblings starts on a
+//multiple of D slots, so a whole group is one cache line when D * sizeof(key) is 64
+//SimdChildren picks the smallest child with vector compares, it only helps arithmetic keys that fill whole registers
+//Compare orders the keys like std::priority_queue's but the other way around: the key it puts first is on top, so
+//the default less<key> is a min heap and greater<key> a max heap, peekKey/extractMin return whichever key is on top
+//a stateless Compare is inlined into the sifts, so it costs nothing over writing < directly
+template<typename key, int D = 2, bool SimdChildren = false, class Compare = less<key> >
 class Heap {
+    static_assert(D >= 2, "a heap node needs at least 2 children");
+
 private:
     key dummyKey;
-    CircularDynamicArray<key> heapArray;
+    //the root sits at slot D - 1, so the children of the node in slot p are the aligned block starting at D * (p - D + 2)
+    //for D = 2 that is the classic 1-based layout with one unused slot in front
+    static const int pad = D - 1;
+    //small heaps live entirely inside the Heap object, 16 slots hold the unused slot plus 15 keys for a binary heap
+    static const int inlineCapacity = D <= 8 ? 16 : 0;
+    //extractMin switches from bottom-up to a plain sift down past this many bytes of keys, about an L2 cache
+    static const size_t bottomUpBytes = 2 << 20;
+    typedef CircularDynamicArray<key, inlineCapacity, DefaultGrowthPolicy, alignedAllocator<key> > storageType;
+    storageType heapArray;
+    Compare comp;
+    //the vector compares find the smallest child, so they only stand in for the default order
+    static const bool simdChildren = SimdChildren && is_same<Compare, less<key> >::value;
+
     int parentIndex(int currentPosition) {
-        return currentPosition / 2;
+        return currentPosition / D + D - 2;
     }
-    int leftChildIndex(int currentPosition) {
-        return currentPosition * 2;
+    int firstChildIndex(int currentPosition) {
+        return D * (currentPosition - D + 2);
     }
-    int rightChildIndex(int currentPosition) {
-        return (currentPosition * 2) + 1;
+
+    //the heap only adds and removes at the end, so the ring never wraps and linearize is just its start
+    key *slots() {
+        return heapArray.linearize().data;
     }
-    void siftDown(CircularDynamicArray<key> &array, int currentIndex) { //performs a sift down in the event of a heap order violation
-        int back = array.length() - 1;
-        while ((leftChildIndex(currentIndex) <= back && heapArray[leftChildIndex(currentIndex)] < heapArray[currentIndex]) || (rightChildIndex(currentIndex) <= back && heapArray[rightChildIndex(currentIndex)] < heapArray[currentIndex])) {
-            bool swapRight = false;
-            if (rightChildIndex(currentIndex) <= back && heapArray[rightChildIndex(currentIndex)] < heapArray[leftChildIndex(currentIndex)]) {
-                swapRight = true;
-            }
 
-            if (swapRight) {
-                swap(heapArray[currentIndex], heapArray[rightChildIndex(currentIndex)]);
-                currentIndex = rightChildIndex(currentIndex);
-            }
-            else {
-                swap(heapArray[currentIndex], heapArray[leftChildIndex(currentIndex)]);
-                currentIndex = leftChildIndex(currentIndex);
-            }
+    //index of the smallest of the count children starting at first
+    int smallestChild(key *a, int first, int count) {
+        if (simdChildren && count == D) return first + ringScan<key>::minIndex(a + first, D);
+        //a pair of numbers is picked without a branch, which one is smaller is a coin flip in a random heap, for other
+        //keys the branch is kept so the next level's loads can be started speculatively
+        if (is_arithmetic<key>::value && count == 2) return first + (int)comp(a[first + 1], a[first]);
+        int best = first;
+        for (int c = first + 1; c < first + count; c++) {
+            if (comp(a[c], a[best])) best = c;
+        }
+        return best;
+    }
+
+    //hole sifts: the key being placed is held aside while the keys it passes each move once into the hole it
+    //leaves, and it is written once at the end, instead of a three move swap at every level
+    void siftDown(int pos) {
+        key *a = slots();
+        int back = heapArray.length();
+        int child = firstChildIndex(pos);
+        if (child >= back) return;
+        key moving = std::move(a[pos]);
+        while (child < back) {
+            int smallest = smallestChild(a, child, std::min(D, back - child));
+            if (!comp(a[smallest], moving)) break;
+            a[pos] = std::move(a[smallest]);
+            pos = smallest;
+            child = firstChildIndex(pos);
+        }
+        a[pos] = std::move(moving);
+    }
+
+    void siftUp(int pos) {
+        key *a = slots();
+        if (pos <= pad || !comp(a[pos], a[parentIndex(pos)])) return;
+        key moving = std::move(a[pos]);
+        do {
+            a[pos] = std::move(a[parentIndex(pos)]);
+            pos = parentIndex(pos);
+        } while (pos > pad && comp(moving, a[parentIndex(pos)]));
+        a[pos] = std::move(moving);
+    }
+
+    //bottom-up refill of the root: the hole there is walked down to a leaf along the smaller children, among the
+    //slots before back, without comparing against the key that will fill it, which then goes in the hole and is
+    //sifted up, that key is usually large so it rarely climbs and this saves a comparison per level over a plain
+    //sift down, but it always reaches the leaf level, which a plain sift down usually stops short of, so heaps past
+    //bottomUpBytes where that level is cold use the plain one, returns the hole
+    int holeToLeaf(key *a, int back) {
+        int hole = pad;
+        int child = firstChildIndex(hole);
+        while (child < back) {
+            int smallest = smallestChild(a, child, std::min(D, back - child));
+            a[hole] = std::move(a[smallest]);
+            hole = smallest;
+            child = firstChildIndex(hole);
+        }
+        return hole;
+    }
+
+    //extractMin's refill with the last key, back is its slot and is left for the caller to delete
+    void refillFromLeaf(key *a, int back) {
+        int hole = holeToLeaf(a, back);
+        if (hole != back) {
+            a[hole] = std::move(a[back]);
+            siftUp(hole);
+        }
+    }
+
+    //Floyd's build: leaves are already heaps, so every parent from the last one back to the root is sifted down,
+    //which is O(n) in total since most of them are near the bottom
+    void heapify() {
+        if (size() < 2) return;
+        for (int i = parentIndex(heapArray.length() - 1); i >= pad; i--) {
+            siftDown(i);
         }
     }
 public:
-    Heap(){
-        heapArray.addEnd(dummyKey);
+    Heap() : dummyKey() { //the dummy key is value-initialized so an empty heap returns 0 or an empty key
+        for (int i = 0; i < pad; i++) heapArray.addEnd(dummyKey);
     }
-    Heap(key k[], int s){ //should make the array a heap by heapify
-        heapArray.addEnd(dummyKey);
+    Heap(key k[], int s) : dummyKey() { //copies the array in with one allocation and makes it a heap by heapify
+        heapArray.reserve(pad + std::max(s, 0));
+        for (int i = 0; i < pad; i++) heapArray.addEnd(dummyKey);
+        if (s > 0) heapArray.appendRange(k, s);
+        heapify();
+    }
+    //takes the keys out of v by moving them, v is left empty
+    Heap(vector<key> &&v) : dummyKey() {
+        heapArray.reserve(pad + (int)v.size());
+        for (int i = 0; i < pad; i++) heapArray.addEnd(dummyKey);
+        for (size_t i = 0; i < v.size(); i++) heapArray.emplaceEnd(std::move(v[i]));
+        v.clear();
+        heapify();
+    }
+    int size() { //number of keys in the heap
+        return heapArray.length() - pad;
+    }
+    key peekKey() {//returns the min of the heap without removing it
+        if (size() == 0) return dummyKey;
+        return slots()[pad];
+    }
+    //returns the min of the heap and removes it, see holeToLeaf for the two ways the root is refilled
+    key extractMin() {
+        if (size() == 0) return dummyKey;
+
+        key *a = slots();
+        int back = heapArray.length() - 1;
+        key returnVal = std::move(a[pad]);
+        if ((size_t)back * sizeof(key) <= bottomUpBytes) {
+            refillFromLeaf(a, back);
+            heapArray.delEnd();
+        }
+        else {
+            if (back != pad) a[pad] = std::move(a[back]);
+            heapArray.delEnd();
+            siftDown(pad);
+        }
+        return returnVal;
+    }
+
+    void insert(key k) {//inserts a key into the heap, sifting up if need be
+        heapArray.emplaceEnd(std::move(k));
+        siftUp(heapArray.length() - 1);
+    }
+
+    //removes the min and inserts k with a single sift, instead of an extractMin and an insert
+    //returns the old min, on an empty heap k is just inserted and the dummy key returned
+    key replaceMin(key k) {
+        if (size() == 0) {
+            insert(std::move(k));
+            return dummyKey;
+        }
+        key *a = slots();
+        int back = heapArray.length();
+        key returnVal = std::move(a[pad]);
+        if ((size_t)back * sizeof(key) <= bottomUpBytes) {
+            int hole = holeToLeaf(a, back);
+            a[hole] = std::move(k);
+            siftUp(hole);
+        }
+        else {
+            a[pad] = std::move(k);
+            siftDown(pad);
+        }
+        return returnVal;
+    }
+
+    //inserts s keys with at most one resize, a batch larger than the heap is appended and the whole array rebuilt
+    //in O(n + s), a smaller one is sifted up key by key since a random key only climbs a level or two on average
+    //and a rebuild has to touch every slot
+    void insertBulk(const key k[], int s) {
+        if (s <= 0) return;
+        if (s > size()) {
+            heapArray.appendRange(k, s);
+            heapify();
+            return;
+        }
+        heapArray.reserve(heapArray.length() + s);
         for (int i = 0; i < s; i++) {
             heapArray.addEnd(k[i]);
+            siftUp(heapArray.length() - 1);
         }
-        int back = heapArray.length() - 1;
-        for (int i = back; i >= 1; i--) {
-            if (leftChildIndex(i) > back && rightChildIndex(i) > back) continue; //skips over leaf nodes
-            else if (rightChildIndex(i) > back) {
-                if(heapArray[i] > heapArray[leftChildIndex(i)]) {
-                    swap(heapArray[i], heapArray[leftChildIndex(i)]);
-                }
-            }
-            else {
-                siftDown(heapArray, i);
+    }
+
+    //writes the heap to out as its array image, so load gets back the same heap without any sifting
+    bool save(ostream &out) {
+        writeBinaryHeader(out, "HEAP", binaryCodec<key>::fixedSize, 0, size());
+        return heapArray.save(out);
+    }
+
+    //replaces the heap with one written by save, returns false if in doesn't hold one
+    //a heap saved with a different D has a different number of unused slots, so it is rejected too
+    bool load(istream &in) {
+        uint64_t count;
+        if (!readBinaryHeader(in, "HEAP", binaryCodec<key>::fixedSize, 0, count)) return false;
+        if (!heapArray.load(in) || (uint64_t)heapArray.length() != count + pad) {
+            heapArray.clear();
+            for (int i = 0; i < pad; i++) heapArray.addEnd(dummyKey);
+            return false;
+        }
+        return true;
+    }
+
+    void printKey() {
+        for (typename storageType::iterator it = heapArray.begin() + pad; it != heapArray.end(); ++it) {
+            cout << *it << " ";
+        }
+        cout << endl;
+    }
+};
+//min heap that gives every inserted key a handle, so a key already in the heap can be changed or removed in O(log n)
+//instead of inserting a duplicate and skipping the stale copy later, positionOf maps each handle to the slot holding
+//its key and every sift keeps it current, handles of removed keys are handed out again by later inserts
+template<typename key, int D = 2>
+class IndexedHeap {
+    static_assert(D >= 2, "a heap node needs at least 2 children");
+
+private:
+    //the handle travels with its key so a move only has to fix up the one positionOf entry
+    struct entry {
+        key k;
+        int handle;
+    };
+
+    key dummyKey;
+    static const int pad = D - 1; //same layout as Heap, the root is at slot D - 1
+    CircularDynamicArray<entry, 0, DefaultGrowthPolicy, alignedAllocator<entry> > heapArray;
+    CircularDynamicArray<int> positionOf; //slot of each handle, -1 while the handle is free
+    CircularDynamicArray<int> freeHandles;
+
+    int parentIndex(int currentPosition) {
+        return currentPosition / D + D - 2;
+    }
+    int firstChildIndex(int currentPosition) {
+        return D * (currentPosition - D + 2);
+    }
+
+    //both arrays only change at the end, so they never wrap and linearize is just their start
+    entry *slots() {
+        return heapArray.linearize().data;
+    }
+    int *positions() {
+        return positionOf.linearize().data;
+    }
+
+    //moves the entry at pos up past every larger parent, each parent moves down once and the entry is written last
+    void siftUp(int pos) {
+        entry *a = slots();
+        int *where = positions();
+        entry moving = std::move(a[pos]);
+        while (pos > pad) {
+            int parent = parentIndex(pos);
+            if (!(moving.k < a[parent].k)) break;
+            a[pos] = std::move(a[parent]);
+            where[a[pos].handle] = pos;
+            pos = parent;
+        }
+        where[moving.handle] = pos;
+        a[pos] = std::move(moving);
+    }
+
+    void siftDown(int pos) {
+        entry *a = slots();
+        int *where = positions();
+        int back = heapArray.length();
+        entry moving = std::move(a[pos]);
+        int child = firstChildIndex(pos);
+        while (child < back) {
+            int last = std::min(child + D, back);
+            int smallest = child;
+            for (int c = child + 1; c < last; c++) {
+                if (a[c].k < a[smallest].k) smallest = c;
             }
+            if (!(a[smallest].k < moving.k)) break;
+            a[pos] = std::move(a[smallest]);
+            where[a[pos].handle] = pos;
+            pos = smallest;
+            child = firstChildIndex(pos);
         }
+        where[moving.handle] = pos;
+        a[pos] = std::move(moving);
+    }
+
+    //the key at pos changed, so it moves whichever way restores heap order
+    void restore(int pos) {
+        entry *a = slots();
+        if (pos > pad && a[pos].k < a[parentIndex(pos)].k) siftUp(pos);
+        else siftDown(pos);
     }
-    key peekKey() {//returns the min of the heap without removing it
-        return heapArray[1];
-    } 
-    key extractMin() {//returns the min of the heap and removes 
-        if (heapArray.length() == 0) return dummyKey;
 
-        key returnVal = heapArray[1];
-        swap(heapArray[1], heapArray[heapArray.length() - 1]);
+    //takes the key at pos out of the heap, fills the hole with the last key and frees the handle
+    key removeAt(int pos) {
+        entry *a = slots();
+        int back = heapArray.length() - 1;
+        int h = a[pos].handle;
+        key returnVal = std::move(a[pos].k);
+        if (pos != back) {
+            a[pos] = std::move(a[back]);
+            positions()[a[pos].handle] = pos;
+        }
         heapArray.delEnd();
+        positions()[h] = -1;
+        freeHandles.addEnd(h);
+        if (pos < heapArray.length()) restore(pos);
+        return returnVal;
+    }
+
+    int slotOf(int h) {
+        if (h < 0 || h >= positionOf.length()) return -1;
+        return positions()[h];
+    }
+
+public:
+    IndexedHeap() : dummyKey() { //the dummy key is value-initialized so an empty heap returns 0 or an empty key
+        entry unused = {dummyKey, -1};
+        for (int i = 0; i < pad; i++) heapArray.addEnd(unused);
+    }
+
+    int size() { //number of keys in the heap
+        return heapArray.length() - pad;
+    }
+
+    //inserts a key and returns its handle, which stays valid until the key is extracted or erased
+    int insert(key k) {
+        int h;
+        if (freeHandles.length() > 0) {
+            h = freeHandles[freeHandles.length() - 1];
+            freeHandles.delEnd();
+        }
+        else {
+            h = positionOf.length();
+            positionOf.addEnd(-1);
+        }
+        entry e = {std::move(k), h};
+        heapArray.addEnd(std::move(e));
+        siftUp(heapArray.length() - 1);
+        return h;
+    }
+
+    key peekKey() { //returns the min of the heap without removing it
+        if (size() == 0) return dummyKey;
+        return slots()[pad].k;
+    }
 
+    //handle of the min, -1 if the heap is empty, read it before extractMin since the handle is freed with the key
+    int peekHandle() {
+        if (size() == 0) return -1;
+        return slots()[pad].handle;
+    }
+
+    key extractMin() { //returns the min of the heap and removes it
+        if (size() == 0) return dummyKey;
+        return removeAt(pad);
+    }
+
+    //whether h is the handle of a key still in the heap
+    bool contains(int h) {
+        return slotOf(h) >= 0;
+    }
+
+    //key of handle h, the dummy key if h isn't in the heap
+    key getKey(int h) {
+        int pos = slotOf(h);
+        if (pos < 0) return dummyKey;
+        return slots()[pos].k;
+    }
+
+    //lowers h's key to k, like FibHeap it returns false and changes nothing if k isn't smaller
+    bool decreaseKey(int h, key k) {
+        int pos = slotOf(h);
+        if (pos < 0 || !(k < slots()[pos].k)) return false;
+        slots()[pos].k = k;
+        siftUp(pos);
+        return true;
+    }
+
+    //raises h's key to k, returns false and changes nothing if k isn't larger
+    bool increaseKey(int h, key k) {
+        int pos = slotOf(h);
+        if (pos < 0 || !(slots()[pos].k < k)) return false;
+        slots()[pos].k = k;
+        siftDown(pos);
+        return true;
+    }
+
+    //sets h's key to k whether it is smaller or larger, returns false if h isn't in the heap
+    bool update(int h, key k) {
+        int pos = slotOf(h);
+        if (pos < 0) return false;
+        slots()[pos].k = k;
+        restore(pos);
+        return true;
+    }
+
+    //removes h's key from the heap, returns false if h isn't in the heap
+    bool erase(int h) {
+        int pos = slotOf(h);
+        if (pos < 0) return false;
+        removeAt(pos);
+        return true;
+    }
+
+    void printKey() {
+        entry *a = slots();
+        for (int i = pad; i < heapArray.length(); i++) {
+            cout << a[i].k << " ";
+        }
+        cout << endl;
+    }
+};
+
+//min-max heap: a binary heap whose levels alternate, every key on an even level (the root's) is the smallest in its
+//subtree and every key on an odd level the largest, so both ends are at the top and a bounded window or top K can
+//drop from either side without a second heap
+//it uses the same storage as Heap<key, 2>, one unused slot in front and the children of slot p at 2p and 2p + 1
+template<typename key, class Compare = less<key> >
+class MinMaxHeap {
+private:
+    key dummyKey;
+    static const int pad = 1;
+    static const int inlineCapacity = 16;
+    typedef CircularDynamicArray<key, inlineCapacity, DefaultGrowthPolicy, alignedAllocator<key> > storageType;
+    storageType heapArray;
+    Compare comp;
+
+    key *slots() {
+        return heapArray.linearize().data;
+    }
+
+    //slot 1 is level 0, so a slot's level is the index of its highest set bit
+    static bool isMinLevel(int pos) {
+        return ((31 - __builtin_clz((unsigned)pos)) & 1) == 0;
+    }
+
+    //whether x belongs above y on a level of the given kind, smaller first on min levels and larger first on max levels
+    bool before(const key &x, const key &y, bool minLevel) {
+        return minLevel ? comp(x, y) : comp(y, x);
+    }
+
+    //slot of the largest key, one of the root's children unless the root is alone
+    int maxIndex() {
+        key *a = slots();
+        int back = heapArray.length();
+        if (back <= 3) return back - 1;
+        return comp(a[2], a[3]) ? 3 : 2;
+    }
+
+    //moves the key at pos up through its grandparents, which are all on the same kind of level as it
+    void siftUpLevel(int pos, bool minLevel) {
+        key *a = slots();
+        if (pos < 4 || !before(a[pos], a[pos / 4], minLevel)) return;
+        key moving = std::move(a[pos]);
+        do {
+            a[pos] = std::move(a[pos / 4]);
+            pos /= 4;
+        } while (pos >= 4 && before(moving, a[pos / 4], minLevel));
+        a[pos] = std::move(moving);
+    }
+
+    //a new key first moves to its parent's level if it belongs there, then climbs the levels of its own kind
+    void siftUp(int pos) {
+        if (pos == pad) return;
+        key *a = slots();
+        int parent = pos / 2;
+        bool minLevel = isMinLevel(pos);
+        if (before(a[parent], a[pos], minLevel)) {
+            swap(a[pos], a[parent]);
+            siftUpLevel(parent, !minLevel);
+        }
+        else {
+            siftUpLevel(pos, minLevel);
+        }
+    }
+
+    //moves the key at pos down, comparing against its children and grandchildren at once: a key passed down to a
+    //grandchild may belong on the level between, in which case it trades places with the grandchild's parent
+    void siftDown(int pos) {
+        key *a = slots();
+        int back = heapArray.length();
+        if (2 * pos >= back) return;
+        bool minLevel = isMinLevel(pos);
+        key moving = std::move(a[pos]);
+        while (2 * pos < back) {
+            int child = 2 * pos;
+            int best = child;
+            if (child + 1 < back && before(a[child + 1], a[best], minLevel)) best = child + 1;
+            int grandchild = 4 * pos;
+            int last = std::min(grandchild + 4, back);
+            for (int g = grandchild; g < last; g++) {
+                if (before(a[g], a[best], minLevel)) best = g;
+            }
+            if (!before(a[best], moving, minLevel)) break;
+            a[pos] = std::move(a[best]);
+            pos = best;
+            if (best < grandchild) break; //a child is on the other kind of level, the key stops there
+            if (before(a[pos / 2], moving, minLevel)) swap(moving, a[pos / 2]);
+        }
+        a[pos] = std::move(moving);
+    }
+
+    //takes the key at pos out, fills the hole with the last key and sifts that down from there
+    key removeAt(int pos) {
+        key *a = slots();
         int back = heapArray.length() - 1;
-        int pos = 1;
-        siftDown(heapArray, 1);
+        key returnVal = std::move(a[pos]);
+        if (pos != back) a[pos] = std::move(a[back]);
+        heapArray.delEnd();
+        if (pos < heapArray.length()) siftDown(pos);
         return returnVal;
     }
 
-    void insert(key k) {//inserts a key into the heap, sifting up if need be
-        heapArray.addEnd(k);
-        int pos = heapArray.length() - 1;
-        while (pos > 1 && heapArray[pos] < heapArray[parentIndex(pos)]) { //sift up
-            swap(heapArray[pos], heapArray[parentIndex(pos)]);
-            pos /= 2;
+public:
+    MinMaxHeap() : dummyKey() {
+        heapArray.addEnd(dummyKey);
+    }
+    MinMaxHeap(key k[], int s) : dummyKey() { //Floyd's build works here too, sifting every parent down from the last
+        heapArray.reserve(pad + std::max(s, 0));
+        heapArray.addEnd(dummyKey);
+        if (s > 0) heapArray.appendRange(k, s);
+        for (int i = (heapArray.length() - 1) / 2; i >= pad; i--) {
+            siftDown(i);
         }
     }
+
+    int size() {
+        return heapArray.length() - pad;
+    }
+
+    void insert(key k) {
+        heapArray.emplaceEnd(std::move(k));
+        siftUp(heapArray.length() - 1);
+    }
+
+    //both ends are O(1) to look at and O(log n) to remove, an empty heap returns the dummy key
+    key peekMin() {
+        if (size() == 0) return dummyKey;
+        return slots()[pad];
+    }
+    key peekMax() {
+        if (size() == 0) return dummyKey;
+        return slots()[maxIndex()];
+    }
+    key extractMin() {
+        if (size() == 0) return dummyKey;
+        return removeAt(pad);
+    }
+    key extractMax() {
+        if (size() == 0) return dummyKey;
+        return removeAt(maxIndex());
+    }
+
     void printKey() {
-        for (int i = 1; i < heapArray.length(); i++) {
-            cout << heapArray[i] << " ";
+        for (typename storageType::iterator it = heapArray.begin() + pad; it != heapArray.end(); ++it) {
+            cout << *it << " ";
         }
         cout << endl;
     }
-};
\ No newline at end of file
+};
+
+//keeps the K largest keys offered from a stream of any length in a min heap of K keys, whose top is the smallest key
+//kept and so the cutoff a new key has to beat, most keys of a long stream don't and are turned away with one compare,
+//one that does replaces the top with a single sift down
+template<typename key, int K, int D = 2>
+class TopK {
+    static_assert(K >= 1, "TopK needs room for at least one key");
+
+private:
+    //offer(k[], s) takes the vector maximum of this many keys at a time and skips the block if it doesn't beat the
+    //cutoff, without looking at its keys one by one
+    static const int prefilterBlock = 64;
+
+    Heap<key, D> heap;
+    key cutoff; //the heap's top once it holds K keys, kept here so checking a key doesn't copy it out of the heap
+
+    //a NaN is larger than nothing and would break the heap order, so it is never kept
+    static bool unordered(const key &k, std::true_type) {
+        return k != k;
+    }
+    static bool unordered(const key &, std::false_type) {
+        return false;
+    }
+    static bool unordered(const key &k) {
+        return unordered(k, typename is_floating_point<key>::type());
+    }
+
+    //adds a key the caller already knows belongs in the top K
+    void accept(const key &k) {
+        if (heap.size() < K) heap.insert(k);
+        else heap.replaceMin(k);
+        if (heap.size() == K) cutoff = heap.peekKey();
+    }
+
+    //the rest of offer once K keys are kept, arithmetic keys skip every block whose vector maximum doesn't beat the cutoff,
+    //a NaN maximum proves nothing so that block is checked key by key
+    int offerFull(const key k[], int s, std::true_type) {
+        int kept = 0;
+        int i = 0;
+        while (i < s) {
+            int block = s - i < prefilterBlock ? s - i : prefilterBlock;
+            key m = ringScan<key>::maximum(k + i, block);
+            if (!(cutoff < m) && m == m) {
+                i += block;
+                continue;
+            }
+            for (int end = i + block; i < end; i++) {
+                if (cutoff < k[i]) {
+                    accept(k[i]);
+                    kept++;
+                }
+            }
+        }
+        return kept;
+    }
+
+    //other keys have no vector maximum, so each one is checked against the cutoff
+    int offerFull(const key k[], int s, std::false_type) {
+        int kept = 0;
+        for (int i = 0; i < s; i++) {
+            if (cutoff < k[i]) {
+                accept(k[i]);
+                kept++;
+            }
+        }
+        return kept;
+    }
+
+public:
+    TopK() : cutoff() {}
+
+    int size() {
+        return heap.size();
+    }
+
+    //the smallest key kept, which a key has to be larger than to get in once K are kept
+    key threshold() {
+        return heap.peekKey();
+    }
+
+    //returns whether k was kept, ties with the cutoff are turned away so the first of equal keys stays
+    bool offer(const key &k) {
+        if (heap.size() == K ? !(cutoff < k) : unordered(k)) return false;
+        accept(k);
+        return true;
+    }
+
+    //offers s keys in order, returns how many were kept at the time they were offered
+    int offer(const key k[], int s) {
+        int kept = 0;
+        int i = 0;
+        for (; i < s && heap.size() < K; i++) {
+            if (unordered(k[i])) continue;
+            accept(k[i]);
+            kept++;
+        }
+        return kept + offerFull(k + i, s - i, typename is_arithmetic<key>::type());
+    }
+
+    //moves the kept keys into out, largest first, and empties the TopK, returns how many were written
+    int extractSorted(key out[]) {
+        int n = heap.size();
+        for (int i = n - 1; i >= 0; i--) out[i] = heap.extractMin();
+        cutoff = key();
+        return n;
+    }
+};
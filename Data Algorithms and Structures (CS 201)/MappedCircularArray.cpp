@@ -0,0 +1,220 @@
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "RingCapacity.cpp"
+using namespace std;
+
+//circular array kept in a memory mapped file so it can be larger than RAM and survives the process exiting,
+//the file is a small header (front, size and MAX) followed by the ring itself, so reopening just maps it again
+//POSIX only, and N has to be trivially copyable since its bytes are written to disk as they are
+template <class N>
+class MappedCircularArray {
+    static_assert(is_trivially_copyable<N>::value, "MappedCircularArray needs a trivially copyable element type");
+
+private:
+    //first 64 bytes of the file, magic and version catch a file that isn't ours or is from another layout
+    struct fileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t elementSize;
+        int64_t MAX;
+        int64_t size;
+        int64_t front;
+        char padding[24];
+    };
+    static_assert(sizeof(fileHeader) == 64, "the header is one 64 byte block");
+
+    static const uint32_t fileVersion = 1;
+    //the ring is indexed with int64_t so it can outgrow an int, this bound only keeps roundUpPow2's doubling in range,
+    //mappable is the real limit
+    static const int64_t maxCapacity = (int64_t)1 << 62;
+    static const size_t headerBytes = sizeof(fileHeader) > alignof(N) ? sizeof(fileHeader) : alignof(N);
+
+    int fd;
+    fileHeader *header; //start of the mapping, the ring follows it
+    N *array;
+    size_t mappedBytes;
+    N dummyElement;
+
+    static const char *magicBytes() {
+        return "CDARING";
+    }
+
+    static size_t fileBytes(int64_t slots) {
+        return headerBytes + (size_t)slots * sizeof(N);
+    }
+
+    //MAX is always kept a power of two, so wrapping an index around the ring is a mask instead of a modulo
+    int64_t wrap(int64_t i) {
+        return i & (header->MAX - 1);
+    }
+
+    //whether a ring of m slots fits in a file, its byte size has to stay within an off_t
+    static bool mappable(int64_t m) {
+        return m >= 1 && m <= maxCapacity && (uint64_t)m <= ((uint64_t)1 << 62) / sizeof(N);
+    }
+
+    //maps the whole file, returns false if mmap fails
+    bool mapFile(size_t bytes) {
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        header = static_cast<fileHeader *>(p);
+        array = reinterpret_cast<N *>(static_cast<char *>(p) + headerBytes);
+        mappedBytes = bytes;
+        return true;
+    }
+
+    void unmapFile() {
+        if (header != nullptr) munmap(header, mappedBytes);
+        header = nullptr;
+        array = nullptr;
+        mappedBytes = 0;
+    }
+
+    //whether an existing file has a header this class wrote, with a ring that fits in the file
+    bool validHeader(size_t bytes) {
+        if (memcmp(header->magic, magicBytes(), 8) != 0) return false;
+        if (header->version != fileVersion || header->elementSize != sizeof(N)) return false;
+        int64_t m = header->MAX;
+        if (!mappable(m) || (m & (m - 1)) != 0 || fileBytes(m) > bytes) return false;
+        return header->size >= 0 && header->size <= m && header->front >= 0 && header->front < m;
+    }
+
+    //doubles the ring: the file is extended, remapped, and the part of a full ring that wrapped around to slot 0 is
+    //copied to just past the old end, after which front..front + size is contiguous again in the larger ring
+    bool grow() {
+        int64_t oldMax = header->MAX;
+        int64_t newMax = oldMax * 2;
+        if (!mappable(newMax)) return false;
+        if (ftruncate(fd, (off_t)fileBytes(newMax)) != 0) return false;
+        unmapFile();
+        if (!mapFile(fileBytes(newMax))) return false;
+        int64_t wrapped = header->front + header->size - oldMax; //elements that wrapped to the start
+        if (wrapped > 0) memcpy(array + oldMax, array, (size_t)wrapped * sizeof(N));
+        header->MAX = newMax; //written last so a crash while copying still leaves the old ring readable
+        return true;
+    }
+
+public:
+    //opens the ring stored at path, or creates it with room for capacity elements if the file doesn't exist
+    //check isOpen afterwards, it is false if the file couldn't be opened or isn't a ring of this element type
+    MappedCircularArray(const char *path, int64_t capacity = 1024) : fd(-1), header(nullptr), array(nullptr), mappedBytes(0), dummyElement() {
+        fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close();
+            return;
+        }
+
+        if (info.st_size == 0) { //new file, writing a fresh header
+            int64_t m = roundUpPow2(capacity < 1 ? (int64_t)1 : capacity, maxCapacity);
+            if (!mappable(m) || ftruncate(fd, (off_t)fileBytes(m)) != 0 || !mapFile(fileBytes(m))) {
+                close();
+                return;
+            }
+            memcpy(header->magic, magicBytes(), 8);
+            header->version = fileVersion;
+            header->elementSize = sizeof(N);
+            header->MAX = m;
+            header->size = 0;
+            header->front = 0;
+        }
+        else if (!mapFile((size_t)info.st_size) || !validHeader((size_t)info.st_size)) {
+            close();
+        }
+    }
+
+    ~MappedCircularArray() {
+        close();
+    }
+
+    //the mapping and file descriptor belong to one object, so it is neither copied nor moved
+    MappedCircularArray(const MappedCircularArray &) = delete;
+    MappedCircularArray &operator=(const MappedCircularArray &) = delete;
+
+    bool isOpen() {
+        return header != nullptr;
+    }
+
+    //unmaps and closes the file, everything written so far stays in it
+    void close() {
+        unmapFile();
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    //writes the header and ring to disk and waits for it, changes reach the file anyway once the page cache flushes,
+    //this is for when they have to survive the machine going down
+    bool flush() {
+        if (!isOpen()) return false;
+        return msync(header, mappedBytes, MS_SYNC) == 0;
+    }
+
+    //returns the value from the array relative to the front
+    N &operator[](int64_t index) {
+        if (!isOpen() || index < 0 || index >= header->size) return dummyElement;
+        return array[wrap(header->front + index)];
+    }
+
+    //returns false if the array is closed or the file couldn't grow
+    bool addEnd(N v) {
+        if (!isOpen()) return false;
+        if (header->size == 0) header->front = 0; //empty array, front may have drifted so it is reset
+        if (header->size == header->MAX && !grow()) return false;
+        array[wrap(header->front + header->size)] = v;
+        header->size++;
+        return true;
+    }
+
+    bool addFront(N v) {
+        if (!isOpen()) return false;
+        if (header->size == 0) header->front = 0;
+        if (header->size == header->MAX && !grow()) return false;
+        int64_t f = wrap(header->front - 1);
+        array[f] = v;
+        header->front = f;
+        header->size++;
+        return true;
+    }
+
+    //the file never shrinks, a rolling window keeps reusing the same slots
+    void delEnd() {
+        if (!isOpen() || header->size == 0) return;
+        header->size--;
+    }
+
+    void delFront() {
+        if (!isOpen() || header->size == 0) return;
+        header->front = wrap(header->front + 1);
+        header->size--;
+    }
+
+    //removes n elements from the front, or all of them if there are fewer than n
+    void popFront(int64_t n) {
+        if (!isOpen() || n <= 0) return;
+        if (n > header->size) n = header->size;
+        header->front = wrap(header->front + n);
+        header->size -= n;
+    }
+
+    int64_t length() {
+        return isOpen() ? header->size : 0;
+    }
+
+    int64_t capacity() {
+        return isOpen() ? header->MAX : 0;
+    }
+
+    //empties the array, the file keeps its size
+    void clear() {
+        if (!isOpen()) return;
+        header->size = 0;
+        header->front = 0;
+    }
+};
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <string>
+#include <cstdint>
+#include <climits>
+#include <memory>
+#include "BinaryIO.cpp"
 using namespace std;
 
 template <typename key, typename value>
@@ -298,6 +302,37 @@ private:
         }
 
     }
+    //builds a perfectly balanced subtree from the sorted k[lo, hi) in linear time, the middle key is the root
+    //halving like this fills every level but the deepest, so colouring only that level red (when it isn't full)
+    //gives every path the same number of black nodes
+    node<key,value> *buildBalanced(key k[], value v[], int lo, int hi, node<key,value> *parent, int depth, int redDepth) {
+        if (lo >= hi) return nil;
+        int mid = lo + (hi - lo) / 2;
+        node<key,value> *n = new node<key,value>(k[mid], v[mid], hi - lo, depth == redDepth ? 'r' : 'b');
+        n->parent = parent;
+        n->leftChild = buildBalanced(k, v, lo, mid, n, depth + 1, redDepth);
+        n->rightChild = buildBalanced(k, v, mid + 1, hi, n, depth + 1, redDepth);
+        return n;
+    }
+
+    //replaces the whole tree with one built from the sorted k and v
+    void bulkBuild(key k[], value v[], int s) {
+        treeDelete(root);
+        int deepest = 0; //depth of the deepest level, the root is depth 0
+        while ((2 << deepest) <= s) deepest++;
+        bool full = (s == (2 << deepest) - 1);
+        root = buildBalanced(k, v, 0, s, nil, 0, full ? -1 : deepest);
+    }
+
+    //copies the keys and values into k and v in sorted order, i is the next free index
+    void collectInorder(node<key,value> *curNode, key k[], value v[], int &i) {
+        if (curNode == nil) return;
+        collectInorder(curNode->leftChild, k, v, i);
+        k[i] = curNode->nodeKey;
+        v[i] = curNode->nodeVal;
+        i++;
+        collectInorder(curNode->rightChild, k, v, i);
+    }
 public:
     RBTree() { //makes an empty tree
         nil = new node<key,value>("nilMarker");
@@ -306,6 +341,14 @@ public:
     RBTree(key k[], value v[], int s) {//build a tree with the arrays, with the size s
         nil = new node<key,value>("nilMarker");
         root = nil;
+        bool sorted = true;
+        for (int i = 1; i < s && sorted; i++) {
+            if (k[i] < k[i - 1]) sorted = false;
+        }
+        if (sorted) { //already sorted keys are built directly in linear time
+            bulkBuild(k, v, s);
+            return;
+        }
         for(int i = 0; i < s; i++) {
             insert(k[i], v[i]);
         }
@@ -490,6 +533,35 @@ public:
     int size() {
         return root->numNodes;
     }
+
+    //writes the tree to out as its sorted keys followed by its values, each one bulk write for trivially copyable types
+    bool save(ostream &out) {
+        int s = root->numNodes;
+        key *k = new key[s];
+        value *v = new value[s];
+        int i = 0;
+        collectInorder(root, k, v, i);
+        writeBinaryHeader(out, "RBTR", binaryCodec<key>::fixedSize, binaryCodec<value>::fixedSize, s);
+        binaryCodec<key>::write(out, k, s);
+        binaryCodec<value>::write(out, v, s);
+        delete[] k;
+        delete[] v;
+        return out.good();
+    }
+
+    //replaces the tree with one written by save, returns false if in doesn't hold one
+    //the sorted arrays are read in bulk and built into a balanced tree in linear time, no inserts or rotations
+    bool load(istream &in) {
+        uint64_t count;
+        if (!readBinaryHeader(in, "RBTR", binaryCodec<key>::fixedSize, binaryCodec<value>::fixedSize, count)) return false;
+        if (count > (uint64_t)INT_MAX) return false;
+        unique_ptr<key[]> k = readBinaryArray<key>(in, count);
+        unique_ptr<value[]> v;
+        if (k) v = readBinaryArray<value>(in, count);
+        bool ok = k && v;
+        bulkBuild(k.get(), v.get(), ok ? (int)count : 0); //a truncated stream leaves the tree empty
+        return ok;
+    }
     void preorder() { //prints the tree keys w/ preorder, list separated by spaces and terminated w/ a newline
         preTraversal(root);
         cout << endl;
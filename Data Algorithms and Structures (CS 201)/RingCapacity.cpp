@@ -0,0 +1,22 @@
+#ifndef CS201_RING_CAPACITY
+#define CS201_RING_CAPACITY
+
+#include <cstdint>
+using namespace std;
+
+//capacity rounding shared by the CS 201 ring buffers, which all keep their capacity a power of two so an index wraps
+//around the ring with a mask instead of a modulo
+
+//the largest power of two an int holds, the most slots a ring indexed by int can have
+static const int maxRingCapacity = 1 << 30;
+
+//rounds s up to the next power of two, never returning less than 1 or more than limit, which has to be a power of two,
+//stopping at limit keeps the doubling from overflowing, so callers check a count against limit before asking for room
+template <class T>
+T roundUpPow2(T s, T limit) {
+    T p = 1;
+    while (p < s && p < limit) p <<= 1;
+    return p;
+}
+
+#endif
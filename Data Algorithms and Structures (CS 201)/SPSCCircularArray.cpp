@@ -0,0 +1,134 @@
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include "RingCapacity.cpp"
+using namespace std;
+
+//fixed capacity ring for exactly one producer thread and one consumer thread, no locks needed
+//only the producer may call tryPush/pushN and only the consumer may call tryPop/popN
+template <class N>
+class SPSCCircularArray {
+private:
+    static const int cacheLine = 64;
+
+    //read only after construction, shared by both threads
+    int MAX;
+    N *array;
+
+    //front and end count every pop and push ever made, the slot is the count masked by MAX - 1 and
+    //end - front is the size, unsigned so the counters may wrap around freely
+    //each index sits on its own cache line with the copy of the other index its owner last saw,
+    //so a thread only touches the other thread's line when the ring looks full or empty
+    alignas(cacheLine) atomic<uint32_t> front; //written by the consumer
+    uint32_t cachedEnd;                        //consumer's last view of end
+    alignas(cacheLine) atomic<uint32_t> end;   //written by the producer
+    uint32_t cachedFront;                      //producer's last view of front
+
+    int wrap(uint32_t i) const { return (int)(i & (uint32_t)(MAX - 1)); }
+
+    //room the producer can fill without waiting, refreshing its view of front only when needed
+    int freeSlots(uint32_t e, int wanted) {
+        int room = MAX - (int)(e - cachedFront);
+        if (room < wanted) {
+            cachedFront = front.load(memory_order_acquire);
+            room = MAX - (int)(e - cachedFront);
+        }
+        return room;
+    }
+
+    //elements the consumer can take without waiting, refreshing its view of end only when needed
+    int readySlots(uint32_t f, int wanted) {
+        int ready = (int)(cachedEnd - f);
+        if (ready < wanted) {
+            cachedEnd = end.load(memory_order_acquire);
+            ready = (int)(cachedEnd - f);
+        }
+        return ready;
+    }
+
+public:
+    //room for s items, rounded up to a power of two and cut down to maxRingCapacity
+    SPSCCircularArray(int s = 1024) : front(0), cachedEnd(0), end(0), cachedFront(0) {
+        MAX = roundUpPow2(s < 1 ? 1 : s, maxRingCapacity);
+        array = static_cast<N *>(::operator new(sizeof(N) * MAX));
+    }
+
+    ~SPSCCircularArray() {
+        uint32_t f = front.load(memory_order_relaxed);
+        uint32_t e = end.load(memory_order_relaxed);
+        for (; f != e; f++) array[wrap(f)].~N();
+        ::operator delete(array);
+    }
+
+    //the indices are tied to this ring's storage and the threads using it, so it is neither copied nor moved
+    SPSCCircularArray(const SPSCCircularArray &) = delete;
+    SPSCCircularArray &operator=(const SPSCCircularArray &) = delete;
+
+    //producer: adds to the end, returns false if the ring is full
+    bool tryPush(const N &item) {
+        uint32_t e = end.load(memory_order_relaxed);
+        if (freeSlots(e, 1) < 1) return false;
+        new (array + wrap(e)) N(item);
+        end.store(e + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPush(N &&item) {
+        uint32_t e = end.load(memory_order_relaxed);
+        if (freeSlots(e, 1) < 1) return false;
+        new (array + wrap(e)) N(std::move(item));
+        end.store(e + 1, memory_order_release);
+        return true;
+    }
+
+    //consumer: removes from the front into out, returns false if the ring is empty
+    bool tryPop(N &out) {
+        uint32_t f = front.load(memory_order_relaxed);
+        if (readySlots(f, 1) < 1) return false;
+        N &slot = array[wrap(f)];
+        out = std::move(slot);
+        slot.~N();
+        front.store(f + 1, memory_order_release);
+        return true;
+    }
+
+    //producer: adds up to count items in order and publishes them with a single store, returns how many fit
+    int pushN(const N *items, int count) {
+        uint32_t e = end.load(memory_order_relaxed);
+        int room = freeSlots(e, count);
+        if (count > room) count = room;
+        for (int i = 0; i < count; i++) new (array + wrap(e + i)) N(items[i]);
+        if (count > 0) end.store(e + count, memory_order_release);
+        return count;
+    }
+
+    //consumer: removes up to count items into out and releases their slots with a single store, returns how many
+    int popN(N *out, int count) {
+        uint32_t f = front.load(memory_order_relaxed);
+        int ready = readySlots(f, count);
+        if (count > ready) count = ready;
+        for (int i = 0; i < count; i++) {
+            N &slot = array[wrap(f + i)];
+            out[i] = std::move(slot);
+            slot.~N();
+        }
+        if (count > 0) front.store(f + count, memory_order_release);
+        return count;
+    }
+
+    //number of elements, exact only when neither thread is running
+    int length() const {
+        uint32_t f = front.load(memory_order_acquire); //front first, so end can only be read at or past it
+        return (int)(end.load(memory_order_acquire) - f);
+    }
+
+    bool empty() const {
+        return length() == 0;
+    }
+
+    int capacity() const {
+        return MAX;
+    }
+};
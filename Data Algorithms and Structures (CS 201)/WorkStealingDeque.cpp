@@ -0,0 +1,127 @@
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "RingCapacity.cpp"
+using namespace std;
+
+//Chase-Lev work-stealing deque: one owner thread adds and removes at the end, any number of thief threads
+//steal from the front, the ring grows when the owner runs out of room
+//only the owner may call addEnd/delEnd, steal may be called from any thread
+template <class N>
+class WorkStealingDeque {
+    //slots are read by thieves while the owner may be overwriting them, so they are atomics and N has to fit in one
+    static_assert(is_trivially_copyable<N>::value, "WorkStealingDeque needs a trivially copyable element type");
+
+private:
+    static const int cacheLine = 64;
+
+    //power of two ring of slots indexed by the ever growing front/end counters masked by MAX - 1
+    struct ringBuffer {
+        int64_t MAX;
+        atomic<N> *slots;
+
+        ringBuffer(int64_t m) : MAX(m), slots(new atomic<N>[m]) {}
+        ~ringBuffer() { delete[] slots; }
+
+        N get(int64_t i) const { return slots[i & (MAX - 1)].load(memory_order_relaxed); }
+        void put(int64_t i, const N &e) { slots[i & (MAX - 1)].store(e, memory_order_relaxed); }
+
+        //a ring twice as large holding the same front..end range
+        ringBuffer *grow(int64_t f, int64_t e) const {
+            ringBuffer *bigger = new ringBuffer(MAX * 2);
+            for (int64_t i = f; i < e; i++) bigger->put(i, get(i));
+            return bigger;
+        }
+    };
+
+    //front is advanced by thieves (and by the owner for the last element), end only by the owner
+    alignas(cacheLine) atomic<int64_t> front;
+    alignas(cacheLine) atomic<int64_t> end;
+    alignas(cacheLine) atomic<ringBuffer *> array;
+
+    //buffers replaced by a grow, a thief may still be reading one so they are only freed with the deque
+    vector<ringBuffer *> retired;
+
+public:
+    //starts with room for s elements, rounded up to a power of two and cut down to maxRingCapacity
+    WorkStealingDeque(int s = 1024) : front(0), end(0) {
+        array.store(new ringBuffer(roundUpPow2(s < 1 ? 1 : s, maxRingCapacity)), memory_order_relaxed);
+    }
+
+    ~WorkStealingDeque() {
+        delete array.load(memory_order_relaxed);
+        for (size_t i = 0; i < retired.size(); i++) delete retired[i];
+    }
+
+    //the counters are tied to this deque's buffers and the threads using it, so it is neither copied nor moved
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    //owner: adds to the end, doubling the ring if it is full
+    void addEnd(const N &e) {
+        int64_t b = end.load(memory_order_relaxed);
+        int64_t t = front.load(memory_order_acquire);
+        ringBuffer *a = array.load(memory_order_relaxed);
+        if (b - t > a->MAX - 1) {
+            ringBuffer *bigger = a->grow(t, b);
+            retired.push_back(a);
+            array.store(bigger, memory_order_release);
+            a = bigger;
+        }
+        a->put(b, e);
+        atomic_thread_fence(memory_order_release);
+        end.store(b + 1, memory_order_relaxed);
+    }
+
+    //owner: removes from the end into out, returns false if the deque is empty
+    //the end is claimed first, only a race with a thief over the last element needs a compare and swap
+    bool delEnd(N &out) {
+        int64_t b = end.load(memory_order_relaxed) - 1;
+        ringBuffer *a = array.load(memory_order_relaxed);
+        end.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t t = front.load(memory_order_relaxed);
+        if (t > b) { //already empty
+            end.store(b + 1, memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) { //last element, the owner and the thieves race for it through front
+            bool won = front.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+            end.store(b + 1, memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    //any thread: removes from the front into out, returns false if the deque looked empty or another
+    //thread took the element first, so a false return does not mean the deque is empty
+    bool steal(N &out) {
+        int64_t t = front.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t b = end.load(memory_order_acquire);
+        if (t >= b) return false;
+        ringBuffer *a = array.load(memory_order_acquire);
+        N e = a->get(t);
+        if (!front.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) return false;
+        out = e;
+        return true;
+    }
+
+    //number of elements, exact only when no thread is running
+    int length() const {
+        int64_t t = front.load(memory_order_acquire);
+        int64_t b = end.load(memory_order_acquire);
+        return b > t ? (int)(b - t) : 0;
+    }
+
+    bool empty() const {
+        return length() == 0;
+    }
+
+    int capacity() const {
+        return (int)array.load(memory_order_acquire)->MAX;
+    }
+};
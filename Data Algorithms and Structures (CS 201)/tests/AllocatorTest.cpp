@@ -0,0 +1,177 @@
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#include "../CircularDynamicArray.cpp"
+using namespace std;
+
+//checks that CircularDynamicArray gets all of its memory through its Alloc parameter: a counting allocator pins down
+//how many allocations each operation makes and that nothing leaks, and a monotonic arena with no fallback shows no
+//buffer comes from anywhere else
+//build: g++ AllocatorTest.cpp -std=c++11 -pthread, as C++17 it also runs the same arena checks with std::pmr
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("FAILED line %d: %s\n", __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+//runs expr and checks it allocated exactly n times
+#define CHECK_ALLOCS(expr, n) \
+    do { \
+        long before = countingStats::allocs; \
+        expr; \
+        if (countingStats::allocs - before != (n)) { \
+            printf("FAILED line %d: %s made %ld allocations, expected %d\n", __LINE__, #expr, countingStats::allocs - before, (n)); \
+            failures++; \
+        } \
+    } while (0)
+
+struct countingStats {
+    static long allocs, frees, liveBytes;
+};
+long countingStats::allocs = 0, countingStats::frees = 0, countingStats::liveBytes = 0;
+
+template <class T>
+struct countingAllocator {
+    typedef T value_type;
+    countingAllocator() {}
+    template <class U> countingAllocator(const countingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        countingStats::allocs++;
+        countingStats::liveBytes += n * sizeof(T);
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *p, size_t n) {
+        countingStats::frees++;
+        countingStats::liveBytes -= n * sizeof(T);
+        ::operator delete(p);
+    }
+};
+template <class T, class U> bool operator==(const countingAllocator<T> &, const countingAllocator<U> &) { return true; }
+template <class T, class U> bool operator!=(const countingAllocator<T> &, const countingAllocator<U> &) { return false; }
+
+//bump pointer arena over a fixed buffer, freeing is a no-op and running out returns nullptr instead of falling back
+struct monotonicArena {
+    char *next;
+    char *end;
+    monotonicArena(char *buffer, size_t bytes) : next(buffer), end(buffer + bytes) {}
+};
+
+template <class T>
+struct arenaAllocator {
+    typedef T value_type;
+    monotonicArena *arena;
+    arenaAllocator(monotonicArena *a) : arena(a) {}
+    template <class U> arenaAllocator(const arenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        size_t misalign = (size_t)arena->next % alignof(T);
+        char *p = arena->next + (misalign == 0 ? 0 : alignof(T) - misalign);
+        if (p + n * sizeof(T) > arena->end) return nullptr;
+        arena->next = p + n * sizeof(T);
+        return reinterpret_cast<T *>(p);
+    }
+    void deallocate(T *, size_t) {}
+};
+template <class T, class U> bool operator==(const arenaAllocator<T> &a, const arenaAllocator<U> &b) { return a.arena == b.arena; }
+template <class T, class U> bool operator!=(const arenaAllocator<T> &a, const arenaAllocator<U> &b) { return a.arena != b.arena; }
+
+typedef CircularDynamicArray<int, 0, DefaultGrowthPolicy, countingAllocator<int> > countedArray;
+
+void countingChecks() {
+    countedArray a;
+    a.reserve(8192);
+    CHECK_ALLOCS(for (int i = 0; i < 5000; i++) a.addEnd((i * 7919) % 5003), 0);
+    CHECK_ALLOCS(a.QuickSelect(10), 1); //the scratch copy
+    CHECK_ALLOCS(a.WCSelect(10), 1);
+    int ks[3] = {1, 2, 3};
+    CHECK_ALLOCS(countedArray r = a.multiSelect(ks, 3), 5); //results, wanted, ranks, found and the scratch copy
+    CHECK_ALLOCS(a.radixSort(), 2); //scratch and the digit counts
+    a.addFront(3);
+    a.delFront();
+    CHECK_ALLOCS(a.stableSort(), 2); //merge scratch and the run table
+    CHECK_ALLOCS(a.buildSearchIndex(), 2); //the Eytzinger index and its rank table
+    CHECK(a.binSearch(17) >= 0);
+    CHECK_ALLOCS(a.parallelStableSort(1), 2); //one thread falls back to stableSort
+    CHECK_ALLOCS(countedArray b(a), 1);
+    CHECK_ALLOCS(a.shrinkToFit(), 0);
+    CHECK_ALLOCS(a.popEnd(4000), 1);
+    CHECK(a.capacity() == 2048);
+    CHECK_ALLOCS(a.shrinkToFit(), 1);
+    CHECK(a.capacity() == 1024);
+    int more[4] = {1, 2, 3, 4};
+    CHECK_ALLOCS(a.appendRange(more, 4), 0);
+
+    CircularDynamicArray<string, 0, DefaultGrowthPolicy, countingAllocator<string> > s;
+    for (int i = 0; i < 100; i++) s.addEnd(to_string(i % 13));
+    CHECK_ALLOCS(s.stableSort(), 2);
+    CHECK(s[0] == "0");
+}
+
+void arenaChecks() {
+    static char buffer[1 << 16];
+    monotonicArena arena(buffer, sizeof(buffer));
+    typedef CircularDynamicArray<int, 0, DefaultGrowthPolicy, arenaAllocator<int> > arenaArray;
+    arenaArray a((arenaAllocator<int>(&arena)));
+    for (int i = 0; i < 1000; i++) a.addFront(1000 - i);
+    a.stableSort();
+    a.radixSort();
+    CHECK(a.QuickSelect(5) == 5);
+    a.buildSearchIndex();
+    CHECK(a.binSearch(500) == 499);
+    CHECK(arena.next > buffer && arena.next <= buffer + sizeof(buffer));
+
+    //an arena allocator is copied along with the array, a move between different arenas copies the elements over
+    static char otherBuffer[1 << 14];
+    monotonicArena other(otherBuffer, sizeof(otherBuffer));
+    arenaArray b(a);
+    CHECK(b.getAllocator().arena == &arena && b[999] == 1000);
+    arenaArray c((arenaAllocator<int>(&other)));
+    c = std::move(b);
+    CHECK(c.getAllocator().arena == &other && c[999] == 1000 && b.length() == 0);
+    arenaArray d(std::move(a));
+    CHECK(d.getAllocator().arena == &arena && d[0] == 1);
+}
+
+#if __cplusplus >= 201703L
+void pmrChecks() {
+    char buffer[1 << 16];
+    pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+    typedef CircularDynamicArray<int, 0, DefaultGrowthPolicy, pmr::polymorphic_allocator<int> > pmrArray;
+    pmrArray a(&arena);
+    for (int i = 0; i < 1000; i++) a.addFront(1000 - i);
+    a.stableSort();
+    a.radixSort();
+    CHECK(a.QuickSelect(5) == 5);
+    a.buildSearchIndex();
+    CHECK(a.binSearch(500) == 499);
+    //polymorphic_allocator doesn't follow a copy, so b uses the default resource
+    pmrArray b(a);
+    CHECK(b.getAllocator().resource() == pmr::get_default_resource());
+    pmrArray c(&arena);
+    c = std::move(b);
+    CHECK(c[999] == 1000 && b.length() == 0);
+    pmrArray d(std::move(a));
+    CHECK(d.getAllocator().resource() == &arena && d[0] == 1);
+}
+#endif
+
+int main() {
+    countingChecks();
+    CHECK(countingStats::liveBytes == 0 && countingStats::allocs == countingStats::frees);
+    arenaChecks();
+#if __cplusplus >= 201703L
+    pmrChecks();
+#endif
+    if (failures == 0) printf("AllocatorTest passed\n");
+    return failures == 0 ? 0 : 1;
+}
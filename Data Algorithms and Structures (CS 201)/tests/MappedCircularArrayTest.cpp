@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include "../MappedCircularArray.cpp"
+using namespace std;
+
+//checks that a MappedCircularArray survives its process exiting: each phase runs in its own forked process, the
+//writer exits without running destructors, and later processes reopen the file and check what is in it
+//also checks a ring of more than 2^31 slots, from a sparse file so it takes no real disk space
+//build: g++ MappedCircularArrayTest.cpp -std=c++11, the files go in $TMPDIR (or /tmp)
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("FAILED line %d: %s\n", __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+struct tick {
+    long long time;
+    double price;
+};
+
+static string tempPath(const char *name) {
+    const char *dir = getenv("TMPDIR");
+    return string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+//runs phase in a child process, the child's exit code is its number of failures
+static void inChild(void (*phase)(const string &), const string &path) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        phase(path);
+        _exit(failures); //no destructors or flush, like a process that is killed
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("FAILED a child process, status %d\n", status);
+        failures++;
+    }
+}
+
+static void write(const string &path) {
+    MappedCircularArray<tick> r(path.c_str(), 4);
+    CHECK(r.isOpen() && r.length() == 0 && r.capacity() == 4);
+    for (int i = 0; i < 3; i++) r.addEnd(tick{i, i * 1.5});
+    r.delFront();
+    r.delFront(); //front drifts to 2
+    for (int i = 3; i < 10; i++) r.addEnd(tick{i, i * 1.5}); //wraps, then grows twice with a wrapped ring
+    r.addFront(tick{1, 1.5});
+    CHECK(r.flush());
+}
+
+static void check(const string &path) {
+    MappedCircularArray<tick> r(path.c_str());
+    CHECK(r.isOpen() && r.length() == 9 && r.capacity() == 16);
+    for (int i = 0; i < 9; i++) CHECK(r[i].time == i + 1 && r[i].price == (i + 1) * 1.5);
+}
+
+static void appendMore(const string &path) {
+    MappedCircularArray<tick> r(path.c_str());
+    r.popFront(4);
+    for (int i = 10; i < 40; i++) r.addEnd(tick{i, i * 1.5});
+    for (int i = 0; i < 3; i++) r.delEnd();
+}
+
+static void checkMore(const string &path) {
+    MappedCircularArray<tick> r(path.c_str());
+    CHECK(r.length() == 32 && r.capacity() == 64);
+    for (int i = 0; i < 32; i++) CHECK(r[i].time == i + 5);
+    CHECK(r[32].time == 0 && r[-1].time == 0); //out of range gives the dummy element
+}
+
+void restartChecks() {
+    string path = tempPath("MappedCircularArrayTest.ring");
+    unlink(path.c_str());
+    inChild(write, path);
+    inChild(check, path);
+    inChild(appendMore, path);
+    inChild(checkMore, path);
+
+    //a file of another element type, or one that isn't a ring, is refused
+    {
+        MappedCircularArray<int> wrongType(path.c_str());
+        CHECK(!wrongType.isOpen());
+    }
+    string junk = tempPath("MappedCircularArrayTest.junk");
+    FILE *f = fopen(junk.c_str(), "w");
+    fputs("not a ring at all, just some text that is long enough to hold a header.............", f);
+    fclose(f);
+    {
+        MappedCircularArray<tick> bad(junk.c_str());
+        CHECK(!bad.isOpen() && bad.length() == 0 && !bad.addEnd(tick{1, 1}));
+    }
+    unlink(junk.c_str());
+    unlink(path.c_str());
+}
+
+//a ring of 2^31 one byte elements whose last two wrapped around to slots 0 and 1, written as a sparse file with the
+//header laid out as MappedCircularArray.cpp describes it
+void largeRingChecks() {
+    string path = tempPath("MappedCircularArrayTest.large");
+    unlink(path.c_str());
+    const int64_t slots = (int64_t)1 << 31;
+    struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t elementSize;
+        int64_t MAX;
+        int64_t size;
+        int64_t front;
+        char padding[24];
+    } header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CDARING", 8);
+    header.version = 1;
+    header.elementSize = 1;
+    header.MAX = slots;
+    header.size = slots;
+    header.front = 2;
+    FILE *f = fopen(path.c_str(), "w");
+    fwrite(&header, sizeof(header), 1, f);
+    fclose(f);
+    if (truncate(path.c_str(), (off_t)(sizeof(header) + slots)) != 0) {
+        printf("skipped the large ring, no room for a sparse file\n");
+        return;
+    }
+
+    {
+        MappedCircularArray<char> r(path.c_str());
+        CHECK(r.isOpen() && r.length() == slots && r.capacity() == slots);
+        r[0] = 'a';
+        r[slots - 3] = 'b'; //the last slot before the ring wraps
+        r[slots - 2] = 'c'; //wrapped to slot 0
+        r[slots - 1] = 'd'; //wrapped to slot 1
+        CHECK(r.addEnd('!')); //grows to 2^32 slots, the two wrapped elements are copied past the old end
+        CHECK(r.length() == slots + 1 && r.capacity() == 2 * slots);
+        CHECK(r[0] == 'a' && r[slots - 3] == 'b' && r[slots - 2] == 'c' && r[slots - 1] == 'd' && r[slots] == '!');
+    }
+    {
+        MappedCircularArray<char> r(path.c_str());
+        CHECK(r.isOpen() && r.length() == slots + 1 && r[slots - 1] == 'd' && r[slots] == '!');
+    }
+    unlink(path.c_str());
+}
+
+int main() {
+    restartChecks();
+    largeRingChecks();
+    if (failures == 0) printf("MappedCircularArrayTest passed\n");
+    return failures == 0 ? 0 : 1;
+}
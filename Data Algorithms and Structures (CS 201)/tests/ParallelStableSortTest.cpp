@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "../CircularDynamicArray.cpp"
+using namespace std;
+
+//checks parallelStableSort against std::stable_sort for element types that are not trivially copyable, where a thread
+//reading an element another thread already moved out sees an empty string instead of the value
+//build: g++ ParallelStableSortTest.cpp -std=c++11 -pthread
+//the threads only overlap on a machine with several cores, add -fsanitize=thread to catch a race on any machine
+
+//ordered by name only, so equal names keep their insertion order if the sort is stable
+struct record {
+    string name;
+    int order;
+    bool operator<(const record &other) const { return name < other.name; }
+    bool operator==(const record &other) const { return name == other.name && order == other.order; }
+};
+
+static int failures = 0;
+
+template <class N>
+void check(vector<N> values, int threads, const char *what) {
+    CircularDynamicArray<N> a;
+    //half added at the front so the ring wraps and the sort has to linearize it first
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i % 2 == 0) a.addEnd(values[i]);
+        else a.addFront(values[i]);
+    }
+    vector<N> expected;
+    for (int i = 0; i < a.length(); i++) expected.push_back(a[i]);
+    stable_sort(expected.begin(), expected.end());
+
+    a.parallelStableSort(threads);
+    int wrong = 0;
+    for (int i = 0; i < a.length(); i++) {
+        if (!(a[i] == expected[i])) wrong++;
+    }
+    if (a.length() != (int)expected.size() || wrong > 0) {
+        printf("FAILED %s, %d elements, %d threads: %d wrong slots\n", what, (int)values.size(), threads, wrong);
+        failures++;
+    }
+}
+
+int main() {
+    mt19937 rng(201);
+    int sizes[] = {40000, 100000, 262147};
+    int threadCounts[] = {2, 3, 5, 8};
+    for (int s = 0; s < 3; s++) {
+        vector<string> strings(sizes[s]);
+        vector<record> records(sizes[s]);
+        for (int i = 0; i < sizes[s]; i++) {
+            strings[i] = "key " + to_string(rng() % 1000000);
+            records[i].name = "name " + to_string(rng() % 500); //many ties
+            records[i].order = i;
+        }
+        for (int t = 0; t < 4; t++) {
+            check(strings, threadCounts[t], "string");
+            check(records, threadCounts[t], "record");
+        }
+    }
+    if (failures == 0) printf("ParallelStableSortTest passed\n");
+    return failures == 0 ? 0 : 1;
+}